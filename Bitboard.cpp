@@ -0,0 +1,151 @@
+#include <algorithm>
+
+#include "Bitboard.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int popcount(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(bits);
+#elif defined(_MSC_VER)
+    return (int)__popcnt(bits);
+#else
+    int count = 0;
+    for(; bits != 0; bits &= bits - 1)
+    {
+        count++;
+    }
+    return count;
+#endif
+}
+
+Bitboard::Bitboard(const BoardLayout& layout) : m_rows((int)layout.size())
+{
+    for(const std::string& line : layout)
+    {
+        m_cols = std::max(m_cols, (int)line.size());
+    }
+    LOG_ASSERT(
+        m_rows <= MAX_ROWS && m_cols <= MAX_COLS,
+        "board is %d by %d, at most %d by %d fits",
+        m_rows,
+        m_cols,
+        MAX_ROWS,
+        MAX_COLS);
+
+    for(int row = 0; row < m_rows; row++)
+    {
+        for(int col = 0; col < (int)layout[row].size(); col++)
+        {
+            const uint32_t bit = (uint32_t)1 << col;
+            switch(layout[row][col])
+            {
+            case BOUNDARY:
+                m_walls[row] |= bit;
+                break;
+            case DOT:
+                m_dots[row] |= bit;
+                break;
+            case SUPER_DOT:
+                m_superDots[row] |= bit;
+                break;
+            case WRAP:
+                m_wraps[row] |= bit;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    m_dotCount = countDots();
+}
+
+char Bitboard::getTile(int row, int col) const
+{
+    if(isWall(row, col))
+    {
+        return BOUNDARY;
+    }
+    if(isDot(row, col))
+    {
+        return DOT;
+    }
+    if(isSuperDot(row, col))
+    {
+        return SUPER_DOT;
+    }
+    if(isWrap(row, col))
+    {
+        return WRAP;
+    }
+    return ' ';
+}
+
+void Bitboard::eatDot(int row, int col)
+{
+    if(!isDot(row, col) && !isSuperDot(row, col))
+    {
+        return;
+    }
+    const uint32_t bit = (uint32_t)1 << col;
+    m_dots[row] &= ~bit;
+    m_superDots[row] &= ~bit;
+    m_dotCount--;
+
+#ifndef NDEBUG
+    LOG_ASSERT(m_dotCount == countDots(), "dot count %d is out of step with the board", m_dotCount);
+#endif
+}
+
+int Bitboard::countDots() const
+{
+    int count = 0;
+    for(int row = 0; row < m_rows; row++)
+    {
+        count += popcount(m_dots[row]) + popcount(m_superDots[row]);
+    }
+    return count;
+}
+
+void Bitboard::hashState(StateHash& hash) const
+{
+    for(int row = 0; row < m_rows; row++)
+    {
+        hash.add(m_dots[row]);
+        hash.add(m_superDots[row]);
+    }
+}
+
+void Bitboard::saveState(StateWriter& writer) const
+{
+    writer.write((uint32_t)m_rows);
+    writer.write((uint32_t)m_cols);
+    for(int row = 0; row < m_rows; row++)
+    {
+        writer.write(m_dots[row]);
+        writer.write(m_superDots[row]);
+    }
+}
+
+bool Bitboard::restoreState(StateReader& reader)
+{
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    reader.read(rows);
+    reader.read(cols);
+    if(rows != (uint32_t)m_rows || cols != (uint32_t)m_cols)
+    {
+        LOG_ERROR("Saved board is %u by %u, expected %d by %d", rows, cols, m_rows, m_cols);
+        return false;
+    }
+    for(int row = 0; row < m_rows; row++)
+    {
+        reader.read(m_dots[row]);
+        reader.read(m_superDots[row]);
+    }
+    m_dotCount = countDots();
+    return true;
+}
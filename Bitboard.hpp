@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <type_traits>
+#include <SDL.h>
+
+#include "StateHash.hpp"
+#include "StateSerializer.hpp"
+#include "util.hpp"
+
+// The board as a bitmask per row for each kind of tile, bit N of a row being column N. A row of the layout fits in a
+// word, so looking at a tile is a shift and a mask, and the whole board is a few hundred bytes with nothing to
+// allocate: resetting a level or copying the board into a snapshot is a plain copy.
+//
+// The number of dots left is kept up to date as they're eaten. countDots works it out again from the masks, which is
+// how a restored board gets its count and how debug builds check the running one.
+class Bitboard
+{
+public:
+    static inline const int MAX_ROWS = 32;
+    static inline const int MAX_COLS = 32;
+
+    // an empty board with no rows
+    Bitboard() = default;
+    explicit Bitboard(const BoardLayout& layout);
+
+    int getRows() const
+    {
+        return m_rows;
+    }
+    int getCols() const
+    {
+        return m_cols;
+    }
+
+    // anything off the board is empty
+    bool isWall(int row, int col) const
+    {
+        return test(m_walls, row, col);
+    }
+    bool isDot(int row, int col) const
+    {
+        return test(m_dots, row, col);
+    }
+    bool isSuperDot(int row, int col) const
+    {
+        return test(m_superDots, row, col);
+    }
+    bool isWrap(int row, int col) const
+    {
+        return test(m_wraps, row, col);
+    }
+
+    // the tile as it would be written in a layout
+    char getTile(int row, int col) const;
+
+    // whole rows, for comparing boards a row at a time
+    uint32_t getWallRow(int row) const
+    {
+        return m_walls[row];
+    }
+    uint32_t getDotRow(int row) const
+    {
+        return m_dots[row];
+    }
+    uint32_t getSuperDotRow(int row) const
+    {
+        return m_superDots[row];
+    }
+    uint32_t getWrapRow(int row) const
+    {
+        return m_wraps[row];
+    }
+
+    // takes the dot or super dot on the tile, if there is one
+    void eatDot(int row, int col);
+
+    int getDotCount() const
+    {
+        return m_dotCount;
+    }
+    int countDots() const;
+
+    // Only the dots change during a game, so only they are hashed and saved. Restoring onto a board of a different
+    // size fails.
+    void hashState(StateHash& hash) const;
+    void saveState(StateWriter& writer) const;
+    bool restoreState(StateReader& reader);
+
+private:
+    static bool test(const std::array<uint32_t, MAX_ROWS>& masks, int row, int col)
+    {
+        return row >= 0 && row < MAX_ROWS && col >= 0 && col < MAX_COLS && (masks[row] >> col & 1) != 0;
+    }
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_dotCount = 0; // dots and super dots
+    std::array<uint32_t, MAX_ROWS> m_walls = {};
+    std::array<uint32_t, MAX_ROWS> m_dots = {};
+    std::array<uint32_t, MAX_ROWS> m_superDots = {};
+    std::array<uint32_t, MAX_ROWS> m_wraps = {};
+};
+
+static_assert(std::is_trivially_copyable_v<Bitboard>, "boards are copied as plain bytes");
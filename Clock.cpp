@@ -0,0 +1,45 @@
+#include <SDL.h>
+
+#include "Clock.hpp"
+#include "Logger.hpp"
+
+RealTimeClock::RealTimeClock()
+: m_startCounter(SDL_GetPerformanceCounter()), m_counterFrequency(SDL_GetPerformanceFrequency())
+{
+}
+
+uint64_t RealTimeClock::now() const
+{
+    // split so the multiplication can't overflow however long the game runs
+    const uint64_t elapsed = SDL_GetPerformanceCounter() - m_startCounter;
+    return elapsed / m_counterFrequency * NANOSECONDS_PER_SECOND
+           + elapsed % m_counterFrequency * NANOSECONDS_PER_SECOND / m_counterFrequency;
+}
+
+ScaledClock::ScaledClock(std::unique_ptr<Clock> source, double scale)
+: m_source(std::move(source)), m_scale(scale), m_sourceBase(m_source->now()), m_scaledBase(0)
+{
+    LOG_ASSERT(scale >= 0, "game time can't run backwards, scale %f", scale);
+}
+
+uint64_t ScaledClock::now() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_scaledBase + (uint64_t)((double)(m_source->now() - m_sourceBase) * m_scale);
+}
+
+double ScaledClock::getRate() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_scale * m_source->getRate();
+}
+
+void ScaledClock::setScale(double scale)
+{
+    LOG_ASSERT(scale >= 0, "game time can't run backwards, scale %f", scale);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t sourceNow = m_source->now();
+    m_scaledBase += (uint64_t)((double)(sourceNow - m_sourceBase) * m_scale);
+    m_sourceBase = sourceNow;
+    m_scale = scale;
+}
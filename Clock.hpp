@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+// Source of time for driving the game, in nanoseconds since an arbitrary start. Nothing that paces the simulation
+// reads the system time directly, so a game can be run faster than real time, paused or stepped by hand.
+// All implementations can be read from any thread.
+class Clock
+{
+public:
+    static inline const uint64_t NANOSECONDS_PER_SECOND = 1'000'000'000;
+
+    virtual ~Clock() = default;
+    virtual uint64_t now() const = 0;
+
+    // clock time passing per unit of real time, zero if it only moves when told to, used to decide how long to sleep
+    virtual double getRate() const = 0;
+};
+
+// Real time at performance counter resolution
+class RealTimeClock : public Clock
+{
+public:
+    RealTimeClock();
+    uint64_t now() const override;
+    double getRate() const override
+    {
+        return 1.0;
+    }
+
+private:
+    uint64_t m_startCounter;
+    uint64_t m_counterFrequency;
+};
+
+// Only moves when advanced, e.g. once per tick in a headless run
+class ManualClock : public Clock
+{
+public:
+    uint64_t now() const override
+    {
+        return m_time;
+    }
+    double getRate() const override
+    {
+        return 0.0;
+    }
+    void advance(uint64_t nanoseconds)
+    {
+        m_time += nanoseconds;
+    }
+
+private:
+    std::atomic<uint64_t> m_time {0};
+};
+
+// Another clock sped up or slowed down, a scale of zero pauses it and a negative one is an error. Changing the scale
+// doesn't make time jump.
+class ScaledClock : public Clock
+{
+public:
+    ScaledClock(std::unique_ptr<Clock> source, double scale);
+    uint64_t now() const override;
+    double getRate() const override;
+    void setScale(double scale);
+
+private:
+    std::unique_ptr<Clock> m_source;
+
+    mutable std::mutex m_mutex;
+    double m_scale;
+    uint64_t m_sourceBase; // source time at the last change of scale
+    uint64_t m_scaledBase; // and what this clock read at that moment
+};
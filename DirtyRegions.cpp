@@ -0,0 +1,51 @@
+#include "DirtyRegions.hpp"
+#include "util.hpp"
+
+void DirtyRegions::add(const SDL_Rect& rect)
+{
+    const SDL_Rect screen = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    SDL_Rect merged;
+    if(!SDL_IntersectRect(&rect, &screen, &merged))
+    {
+        return;
+    }
+
+    // absorb every existing rectangle that overlaps, repeating since the grown rectangle may reach new ones
+    bool grew = true;
+    while(grew)
+    {
+        grew = false;
+        for(auto it = m_rects.begin(); it != m_rects.end(); it++)
+        {
+            if(SDL_HasIntersection(&merged, &*it))
+            {
+                SDL_UnionRect(&merged, &*it, &merged);
+                m_rects.erase(it);
+                grew = true;
+                break;
+            }
+        }
+    }
+
+    m_rects.push_back(merged);
+
+    if(m_rects.size() > MAX_RECTS)
+    {
+        SDL_Rect bounds = m_rects[0];
+        for(const auto& other : m_rects)
+        {
+            SDL_UnionRect(&bounds, &other, &bounds);
+        }
+        m_rects.assign(1, bounds);
+    }
+}
+
+void DirtyRegions::addFullScreen()
+{
+    m_rects.assign(1, {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+}
+
+void DirtyRegions::clear()
+{
+    m_rects.clear();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+// Screen areas that changed since the last frame. Overlapping rectangles are merged as they are added, and if too
+// many disjoint rectangles accumulate they are collapsed into their bounding box.
+class DirtyRegions
+{
+public:
+    void add(const SDL_Rect& rect);
+    void addFullScreen();
+    void clear();
+
+    bool empty() const
+    {
+        return m_rects.empty();
+    }
+    const std::vector<SDL_Rect>& getRects() const
+    {
+        return m_rects;
+    }
+
+private:
+    static inline const size_t MAX_RECTS = 16;
+
+    std::vector<SDL_Rect> m_rects;
+};
@@ -0,0 +1,243 @@
+#include <stdlib.h>
+#include <algorithm>
+
+#include "DrawBatch.hpp"
+#include "Framebuffer.hpp"
+
+DrawBatch::DrawBatch(SDL_Renderer* renderer, Framebuffer* framebuffer)
+: m_renderer(renderer), m_framebuffer(framebuffer)
+{
+}
+
+void DrawBatch::setTexturePixels(SDL_Texture* texture, const uint32_t* pixels, int pitchPixels)
+{
+    m_texturePixels.push_back({texture, pixels, pitchPixels});
+}
+
+void DrawBatch::removeTexturePixels(SDL_Texture* texture)
+{
+    // must happen before the texture is destroyed, or a new texture at the same address would pick up stale pixels
+    for(auto it = m_texturePixels.begin(); it != m_texturePixels.end(); it++)
+    {
+        if(it->texture == texture)
+        {
+            m_texturePixels.erase(it);
+            return;
+        }
+    }
+}
+
+DrawBatch::ColorGroup& DrawBatch::getColorGroup(const SDL_Color& color)
+{
+    // only a handful of colours are used per frame, so a linear search is fine
+    for(size_t i = 0; i < m_activeColorGroups; i++)
+    {
+        const SDL_Color& groupColor = m_colorGroups[i].color;
+        if(groupColor.r == color.r && groupColor.g == color.g && groupColor.b == color.b && groupColor.a == color.a)
+        {
+            return m_colorGroups[i];
+        }
+    }
+
+    if(m_activeColorGroups == m_colorGroups.size())
+    {
+        m_colorGroups.emplace_back();
+    }
+    ColorGroup& group = m_colorGroups[m_activeColorGroups++];
+    group.color = color;
+    return group;
+}
+
+DrawBatch::TextureGroup& DrawBatch::getTextureGroup(SDL_Texture* texture)
+{
+    for(size_t i = 0; i < m_activeTextureGroups; i++)
+    {
+        if(m_textureGroups[i].texture == texture)
+        {
+            return m_textureGroups[i];
+        }
+    }
+
+    if(m_activeTextureGroups == m_textureGroups.size())
+    {
+        m_textureGroups.emplace_back();
+    }
+    TextureGroup& group = m_textureGroups[m_activeTextureGroups++];
+    group.texture = texture;
+
+    // queried once per frame so a texture that was recreated at the same address is still handled
+    int width = 1;
+    int height = 1;
+    SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
+    group.width = (float)width;
+    group.height = (float)height;
+
+    group.pixels = nullptr;
+    group.pitchPixels = 0;
+    for(const auto& texturePixels : m_texturePixels)
+    {
+        if(texturePixels.texture == texture)
+        {
+            group.pixels = texturePixels.pixels;
+            group.pitchPixels = texturePixels.pitchPixels;
+        }
+    }
+    return group;
+}
+
+void DrawBatch::drawPoint(int x, int y, const SDL_Color& color)
+{
+    getColorGroup(color).points.push_back({x, y});
+}
+
+void DrawBatch::drawLine(int x1, int y1, int x2, int y2, const SDL_Color& color)
+{
+    ColorGroup& group = getColorGroup(color);
+
+    // axis aligned lines (all of the maze) are one pixel wide rectangles, which batch into a single fill call
+    if(x1 == x2)
+    {
+        group.rects.push_back({x1, std::min(y1, y2), 1, abs(y2 - y1) + 1});
+    }
+    else if(y1 == y2)
+    {
+        group.rects.push_back({std::min(x1, x2), y1, abs(x2 - x1) + 1, 1});
+    }
+    else
+    {
+        group.lineSegments.push_back({x1, y1});
+        group.lineSegments.push_back({x2, y2});
+    }
+}
+
+void DrawBatch::fillRect(const SDL_Rect& rect, const SDL_Color& color)
+{
+    getColorGroup(color).rects.push_back(rect);
+}
+
+void DrawBatch::copy(SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination, const SDL_Color& tint)
+{
+    TextureGroup& group = getTextureGroup(texture);
+    group.copies.push_back({source, destination, tint});
+
+    const float left = (float)destination.x;
+    const float top = (float)destination.y;
+    const float right = (float)(destination.x + destination.w);
+    const float bottom = (float)(destination.y + destination.h);
+    const float u0 = source.x / group.width;
+    const float v0 = source.y / group.height;
+    const float u1 = (source.x + source.w) / group.width;
+    const float v1 = (source.y + source.h) / group.height;
+
+    const int base = (int)group.vertices.size();
+    group.vertices.push_back({{left, top}, tint, {u0, v0}});
+    group.vertices.push_back({{right, top}, tint, {u1, v0}});
+    group.vertices.push_back({{right, bottom}, tint, {u1, v1}});
+    group.vertices.push_back({{left, bottom}, tint, {u0, v1}});
+
+    for(int index : {0, 1, 2, 0, 2, 3})
+    {
+        group.indices.push_back(base + index);
+    }
+}
+
+void DrawBatch::submit()
+{
+    // render targets other than the framebuffer itself, such as the board texture, are drawn by SDL
+    if(m_framebuffer != nullptr && SDL_GetRenderTarget(m_renderer) == nullptr)
+    {
+        submitToFramebuffer();
+        return;
+    }
+
+    for(size_t i = 0; i < m_activeColorGroups; i++)
+    {
+        const ColorGroup& group = m_colorGroups[i];
+        SDL_SetRenderDrawColor(m_renderer, group.color.r, group.color.g, group.color.b, group.color.a);
+
+        if(!group.rects.empty())
+        {
+            SDL_RenderFillRects(m_renderer, group.rects.data(), (int)group.rects.size());
+        }
+
+        // SDL_RenderDrawLines only draws connected lines, so disjoint segments are submitted per segment
+        for(size_t point = 0; point + 1 < group.lineSegments.size(); point += 2)
+        {
+            SDL_RenderDrawLines(m_renderer, &group.lineSegments[point], 2);
+        }
+
+        if(!group.points.empty())
+        {
+            SDL_RenderDrawPoints(m_renderer, group.points.data(), (int)group.points.size());
+        }
+    }
+
+    for(size_t i = 0; i < m_activeTextureGroups; i++)
+    {
+        const TextureGroup& group = m_textureGroups[i];
+        SDL_RenderGeometry(
+            m_renderer,
+            group.texture,
+            group.vertices.data(),
+            (int)group.vertices.size(),
+            group.indices.data(),
+            (int)group.indices.size());
+    }
+}
+
+void DrawBatch::submitToFramebuffer()
+{
+    for(size_t i = 0; i < m_activeColorGroups; i++)
+    {
+        const ColorGroup& group = m_colorGroups[i];
+        m_framebuffer->fillRects(group.rects.data(), (int)group.rects.size(), group.color);
+
+        if(!group.lineSegments.empty())
+        {
+            SDL_SetRenderDrawColor(m_renderer, group.color.r, group.color.g, group.color.b, group.color.a);
+            for(size_t point = 0; point + 1 < group.lineSegments.size(); point += 2)
+            {
+                SDL_RenderDrawLines(m_renderer, &group.lineSegments[point], 2);
+            }
+        }
+
+        m_framebuffer->drawPoints(group.points.data(), (int)group.points.size(), group.color);
+    }
+
+    for(size_t i = 0; i < m_activeTextureGroups; i++)
+    {
+        const TextureGroup& group = m_textureGroups[i];
+        for(const Copy& copy : group.copies)
+        {
+            if(group.pixels != nullptr)
+            {
+                m_framebuffer->blit(group.pixels, group.pitchPixels, copy.source, copy.destination, copy.tint);
+            }
+            else
+            {
+                // the software renderer turns a copy into a surface blit, which is much cheaper than geometry
+                SDL_SetTextureColorMod(group.texture, copy.tint.r, copy.tint.g, copy.tint.b);
+                SDL_RenderCopy(m_renderer, group.texture, &copy.source, &copy.destination);
+            }
+        }
+    }
+}
+
+void DrawBatch::clear()
+{
+    for(size_t i = 0; i < m_activeColorGroups; i++)
+    {
+        m_colorGroups[i].rects.clear();
+        m_colorGroups[i].lineSegments.clear();
+        m_colorGroups[i].points.clear();
+    }
+    m_activeColorGroups = 0;
+
+    for(size_t i = 0; i < m_activeTextureGroups; i++)
+    {
+        m_textureGroups[i].copies.clear();
+        m_textureGroups[i].vertices.clear();
+        m_textureGroups[i].indices.clear();
+    }
+    m_activeTextureGroups = 0;
+}
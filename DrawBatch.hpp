@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+// forward declaration
+class Framebuffer;
+
+// Frame scoped command buffer for all drawing. Commands are grouped by colour and primitive type (or by texture for
+// copies) and each group is submitted with a single SDL call when the batch is flushed.
+//
+// Flushing submits all primitives before all texture copies, each in order of first use, so anything that has to be
+// layered differently must flush in between.
+//
+// When drawing to a Framebuffer, fills and copies from textures with known pixels are rasterized directly into it.
+class DrawBatch
+{
+public:
+    DrawBatch(SDL_Renderer* renderer, Framebuffer* framebuffer = nullptr);
+    DrawBatch(DrawBatch&) = delete;
+    DrawBatch& operator=(DrawBatch&) = delete;
+
+    void drawPoint(int x, int y, const SDL_Color& color);
+    void drawLine(int x1, int y1, int x2, int y2, const SDL_Color& color);
+    void fillRect(const SDL_Rect& rect, const SDL_Color& color);
+    void copy(SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination, const SDL_Color& tint);
+
+    // lets a framebuffer blit straight from the CPU copy of a texture's pixels, which must outlive the texture
+    void setTexturePixels(SDL_Texture* texture, const uint32_t* pixels, int pitchPixels);
+    void removeTexturePixels(SDL_Texture* texture);
+
+    // submit can be called repeatedly, e.g. once per clip rectangle, before the commands are cleared
+    void submit();
+    void clear();
+    void flush()
+    {
+        submit();
+        clear();
+    }
+
+    SDL_Renderer* getRenderer() const
+    {
+        return m_renderer;
+    }
+
+private:
+    struct ColorGroup
+    {
+        SDL_Color color;
+        std::vector<SDL_Point> points;
+        std::vector<SDL_Rect> rects;
+        std::vector<SDL_Point> lineSegments; // pairs of end points
+    };
+
+    struct Copy
+    {
+        SDL_Rect source;
+        SDL_Rect destination;
+        SDL_Color tint;
+    };
+
+    struct TextureGroup
+    {
+        SDL_Texture* texture;
+        float width;
+        float height;
+        const uint32_t* pixels;
+        int pitchPixels;
+        std::vector<Copy> copies;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+    };
+
+    struct TexturePixels
+    {
+        SDL_Texture* texture;
+        const uint32_t* pixels;
+        int pitchPixels;
+    };
+
+    ColorGroup& getColorGroup(const SDL_Color& color);
+    TextureGroup& getTextureGroup(SDL_Texture* texture);
+    void submitToFramebuffer();
+
+private:
+    SDL_Renderer* m_renderer;
+    Framebuffer* m_framebuffer;
+    std::vector<TexturePixels> m_texturePixels;
+
+    // groups keep their storage between frames so a steady state frame does not allocate
+    std::vector<ColorGroup> m_colorGroups;
+    size_t m_activeColorGroups = 0;
+    std::vector<TextureGroup> m_textureGroups;
+    size_t m_activeTextureGroups = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "FrameSnapshot.hpp"
+
+// Anything that presents simulation snapshots. The simulation doesn't depend on any of these, so it can run with a
+// window (GameRenderer) or with none at all (NullRenderer).
+class FrameRenderer
+{
+public:
+    virtual ~FrameRenderer() = default;
+    // clockTime is the game clock's time now, to place things between the snapshot's tick and the next
+    virtual void render(const FrameSnapshot& snapshot, uint64_t clockTime) = 0;
+};
+
+// Discards every frame, for running the game without a window or video driver
+class NullRenderer : public FrameRenderer
+{
+public:
+    void render(const FrameSnapshot&, uint64_t) override {}
+};
@@ -0,0 +1,48 @@
+#include "FrameScheduler.hpp"
+#include "util.hpp"
+
+static const uint64_t NANOSECONDS_PER_MILLISECOND = 1'000'000;
+
+FrameScheduler::FrameScheduler(int targetFps)
+{
+    if(targetFps > 0)
+    {
+        m_framePeriod = Clock::NANOSECONDS_PER_SECOND / (uint64_t)targetFps;
+        LOG_INFO("Frame rate limited to %d fps", targetFps);
+    }
+    m_nextFrame = m_clock.now();
+}
+
+bool FrameScheduler::waitForEvent(SDL_Event& event)
+{
+    const uint64_t now = m_clock.now();
+    if(m_framePeriod == 0 || now >= m_nextFrame)
+    {
+        return SDL_PollEvent(&event);
+    }
+
+    // round up, waking a millisecond late is better than spinning until the frame is due
+    const uint64_t timeout = (m_nextFrame - now + NANOSECONDS_PER_MILLISECOND - 1) / NANOSECONDS_PER_MILLISECOND;
+    return SDL_WaitEventTimeout(&event, (int)timeout);
+}
+
+bool FrameScheduler::isFrameDue() const
+{
+    return m_framePeriod == 0 || m_clock.now() >= m_nextFrame;
+}
+
+void FrameScheduler::onFrame()
+{
+    if(m_framePeriod == 0)
+    {
+        return;
+    }
+
+    // after falling more than a frame behind, start over from now rather than rushing to catch up
+    const uint64_t now = m_clock.now();
+    if(now > m_nextFrame && now - m_nextFrame > m_framePeriod)
+    {
+        m_nextFrame = now;
+    }
+    m_nextFrame += m_framePeriod;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "Clock.hpp"
+
+// Paces the main loop so an idle game sleeps instead of spinning. Between frames the thread blocks in
+// SDL_WaitEventTimeout, waking for input or the next frame, whichever comes first.
+// A target of zero frames per second leaves the pacing to vsync, where SDL_RenderPresent blocks until the next
+// vertical blank.
+// Frames follow real time even when the game's clock is scaled, the display doesn't refresh any faster.
+class FrameScheduler
+{
+public:
+    FrameScheduler(int targetFps);
+
+    // returns true with the first event if one arrived before the wait ran out, the rest can then be polled
+    bool waitForEvent(SDL_Event& event);
+
+    bool isFrameDue() const;
+    void onFrame();
+
+private:
+    RealTimeClock m_clock;
+    uint64_t m_framePeriod = 0; // in nanoseconds, zero when unlimited
+    uint64_t m_nextFrame = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+#include "Bitboard.hpp"
+#include "util.hpp"
+
+// One object on screen as of a simulation tick
+struct SpriteSnapshot
+{
+    bool visible = false;
+    SDL_Point previousCenter = {0, 0}; // as of the tick before, to interpolate from
+    SDL_Point center = {0, 0};
+    int width = 0;
+    int height = 0;
+    SDL_Color color = COLOR_WHITE;               // ghosts
+    Direction facingDirection = Direction::LEFT; // pacman
+    int frame = 0;                               // pacman's mouth, or which fruit
+};
+
+// Everything the renderer needs from the simulation, copied out after a tick. Rendering only ever reads these, so it
+// never touches live game state. Snapshots are reused, so after the first few the copies don't allocate.
+struct FrameSnapshot
+{
+    uint64_t tick = 0;
+    uint64_t tickTime = 0; // game clock times at which this tick and the next are due, to interpolate
+    uint64_t nextTickTime = 0;
+
+    Bitboard board;
+    SpriteSnapshot pacman;
+    std::vector<SpriteSnapshot> ghosts;
+    SpriteSnapshot fruit;
+    std::vector<SpriteSnapshot> displayFruits; // fruits shown for the levels reached
+
+    int score = 0;
+    int highScore = 0;
+    int lives = 0;
+    int level = 0;
+    bool readyDisplayed = false;
+    bool gameOver = false;
+};
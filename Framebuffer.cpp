@@ -0,0 +1,302 @@
+#include <algorithm>
+
+#include "Framebuffer.hpp"
+#include "util.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRAMEBUFFER_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+    uint32_t toPixel(const SDL_Color& color)
+    {
+        return (uint32_t)color.a << 24 | (uint32_t)color.r << 16 | (uint32_t)color.g << 8 | (uint32_t)color.b;
+    }
+
+    // exact floor(value * factor / 255) for 8 bit channels, the same rounding SDL uses for colour modulation
+    uint32_t modulateChannel(uint32_t value, uint32_t factor)
+    {
+        uint32_t product = value * factor;
+        return (product + 1 + (product >> 8)) >> 8;
+    }
+
+    void fillSpanScalar(uint32_t* target, int count, uint32_t pixel)
+    {
+        std::fill_n(target, count, pixel);
+    }
+
+    // atlas sprites only contain fully transparent or fully opaque pixels, so blending is a select on the alpha bit
+    void blendSpanScalar(uint32_t* target, const uint32_t* source, int count, const SDL_Color& tint)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            uint32_t pixel = source[i];
+            if((pixel >> 31) == 0)
+            {
+                continue;
+            }
+            target[i] = (pixel & 0xff000000) | modulateChannel((pixel >> 16) & 0xff, tint.r) << 16
+                        | modulateChannel((pixel >> 8) & 0xff, tint.g) << 8 | modulateChannel(pixel & 0xff, tint.b);
+        }
+    }
+
+#ifdef FRAMEBUFFER_X86_SIMD
+    void fillSpanSSE2(uint32_t* target, int count, uint32_t pixel)
+    {
+        const __m128i value = _mm_set1_epi32((int)pixel);
+        int i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_si128((__m128i*)(target + i), value);
+        }
+        fillSpanScalar(target + i, count - i, pixel);
+    }
+
+    __m128i modulateSSE2(__m128i channels, __m128i factors)
+    {
+        __m128i product = _mm_mullo_epi16(channels, factors);
+        __m128i rounded = _mm_add_epi16(_mm_add_epi16(product, _mm_set1_epi16(1)), _mm_srli_epi16(product, 8));
+        return _mm_srli_epi16(rounded, 8);
+    }
+
+    void blendSpanSSE2(uint32_t* target, const uint32_t* source, int count, const SDL_Color& tint)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        // ARGB8888 pixels are stored as B, G, R, A bytes
+        const __m128i factors = _mm_setr_epi16(tint.b, tint.g, tint.r, 255, tint.b, tint.g, tint.r, 255);
+        int i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i));
+            __m128i low = modulateSSE2(_mm_unpacklo_epi8(pixels, zero), factors);
+            __m128i high = modulateSSE2(_mm_unpackhi_epi8(pixels, zero), factors);
+            __m128i tinted = _mm_packus_epi16(low, high);
+            __m128i opaque = _mm_srai_epi32(pixels, 31);
+            __m128i existing = _mm_loadu_si128((const __m128i*)(target + i));
+            __m128i result = _mm_or_si128(_mm_and_si128(opaque, tinted), _mm_andnot_si128(opaque, existing));
+            _mm_storeu_si128((__m128i*)(target + i), result);
+        }
+        blendSpanScalar(target + i, source + i, count - i, tint);
+    }
+
+    TARGET_AVX2 void fillSpanAVX2(uint32_t* target, int count, uint32_t pixel)
+    {
+        const __m256i value = _mm256_set1_epi32((int)pixel);
+        int i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_si256((__m256i*)(target + i), value);
+        }
+        fillSpanScalar(target + i, count - i, pixel);
+    }
+
+    TARGET_AVX2 __m256i modulateAVX2(__m256i channels, __m256i factors)
+    {
+        __m256i product = _mm256_mullo_epi16(channels, factors);
+        __m256i rounded =
+            _mm256_add_epi16(_mm256_add_epi16(product, _mm256_set1_epi16(1)), _mm256_srli_epi16(product, 8));
+        return _mm256_srli_epi16(rounded, 8);
+    }
+
+    TARGET_AVX2 void blendSpanAVX2(uint32_t* target, const uint32_t* source, int count, const SDL_Color& tint)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        // clang-format off
+        const __m256i factors = _mm256_setr_epi16(
+            tint.b, tint.g, tint.r, 255, tint.b, tint.g, tint.r, 255,
+            tint.b, tint.g, tint.r, 255, tint.b, tint.g, tint.r, 255);
+        // clang-format on
+        int i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            // unpack and pack both work within 128 bit lanes, so the pixel order is preserved
+            __m256i pixels = _mm256_loadu_si256((const __m256i*)(source + i));
+            __m256i low = modulateAVX2(_mm256_unpacklo_epi8(pixels, zero), factors);
+            __m256i high = modulateAVX2(_mm256_unpackhi_epi8(pixels, zero), factors);
+            __m256i tinted = _mm256_packus_epi16(low, high);
+            __m256i opaque = _mm256_srai_epi32(pixels, 31);
+            __m256i existing = _mm256_loadu_si256((const __m256i*)(target + i));
+            _mm256_storeu_si256((__m256i*)(target + i), _mm256_blendv_epi8(existing, tinted, opaque));
+        }
+        blendSpanScalar(target + i, source + i, count - i, tint);
+    }
+#endif
+
+    struct SpanFunctions
+    {
+        void (*fill)(uint32_t* target, int count, uint32_t pixel);
+        void (*blend)(uint32_t* target, const uint32_t* source, int count, const SDL_Color& tint);
+    };
+
+    const SpanFunctions& getSpanFunctions()
+    {
+        static const SpanFunctions functions = []() -> SpanFunctions
+        {
+#ifdef FRAMEBUFFER_X86_SIMD
+            if(SDL_HasAVX2())
+            {
+                LOG_INFO("Framebuffer using AVX2 spans");
+                return {fillSpanAVX2, blendSpanAVX2};
+            }
+            LOG_INFO("Framebuffer using SSE2 spans");
+            return {fillSpanSSE2, blendSpanSSE2};
+#else
+            return {fillSpanScalar, blendSpanScalar};
+#endif
+        }();
+        return functions;
+    }
+}
+
+Framebuffer::Framebuffer(SDL_Window* window, bool vsync)
+{
+    m_surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    LOG_ASSERT(m_surface != nullptr, "Error creating framebuffer: %s", SDL_GetError());
+
+    m_renderer = SDL_CreateSoftwareRenderer(m_surface);
+    LOG_ASSERT(m_renderer != nullptr, "Error creating software renderer: %s", SDL_GetError());
+
+    if(window != nullptr)
+    {
+        m_windowRenderer = SDL_CreateRenderer(window, -1, vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+        LOG_ASSERT(m_windowRenderer != nullptr, "Error creating window renderer: %s", SDL_GetError());
+        m_windowTexture = SDL_CreateTexture(
+            m_windowRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+        LOG_ASSERT(m_windowTexture != nullptr, "Error creating framebuffer texture: %s", SDL_GetError());
+    }
+
+    // pick the span implementation up front rather than during the first frame
+    getSpanFunctions();
+}
+
+Framebuffer::~Framebuffer()
+{
+    if(m_windowTexture != nullptr)
+    {
+        SDL_DestroyTexture(m_windowTexture);
+    }
+    if(m_windowRenderer != nullptr)
+    {
+        SDL_DestroyRenderer(m_windowRenderer);
+    }
+    SDL_DestroyRenderer(m_renderer);
+    SDL_FreeSurface(m_surface);
+}
+
+SDL_Rect Framebuffer::getClipRect() const
+{
+    SDL_Rect bounds = {0, 0, m_surface->w, m_surface->h};
+    if(SDL_RenderIsClipEnabled(m_renderer))
+    {
+        SDL_Rect clip;
+        SDL_RenderGetClipRect(m_renderer, &clip);
+        if(!SDL_IntersectRect(&clip, &bounds, &bounds))
+        {
+            return {0, 0, 0, 0};
+        }
+    }
+    return bounds;
+}
+
+void Framebuffer::fillRects(const SDL_Rect* rects, int count, const SDL_Color& color)
+{
+    SDL_RenderFlush(m_renderer);
+
+    const SDL_Rect clip = getClipRect();
+    const uint32_t pixel = toPixel(color);
+    const auto fill = getSpanFunctions().fill;
+    uint32_t* pixels = getPixels();
+    const int pitch = getPitchPixels();
+
+    for(int i = 0; i < count; i++)
+    {
+        SDL_Rect visible;
+        if(!SDL_IntersectRect(&rects[i], &clip, &visible))
+        {
+            continue;
+        }
+        for(int y = visible.y; y < visible.y + visible.h; y++)
+        {
+            fill(pixels + y * pitch + visible.x, visible.w, pixel);
+        }
+    }
+}
+
+void Framebuffer::drawPoints(const SDL_Point* points, int count, const SDL_Color& color)
+{
+    SDL_RenderFlush(m_renderer);
+
+    const SDL_Rect clip = getClipRect();
+    const uint32_t pixel = toPixel(color);
+    uint32_t* pixels = getPixels();
+    const int pitch = getPitchPixels();
+
+    for(int i = 0; i < count; i++)
+    {
+        const SDL_Point& point = points[i];
+        if(point.x >= clip.x && point.x < clip.x + clip.w && point.y >= clip.y && point.y < clip.y + clip.h)
+        {
+            pixels[point.y * pitch + point.x] = pixel;
+        }
+    }
+}
+
+void Framebuffer::blit(
+    const uint32_t* pixels,
+    int pitchPixels,
+    const SDL_Rect& source,
+    const SDL_Rect& destination,
+    const SDL_Color& tint)
+{
+    SDL_Rect visible;
+    const SDL_Rect clip = getClipRect();
+    if(source.w <= 0 || source.h <= 0 || !SDL_IntersectRect(&destination, &clip, &visible))
+    {
+        return;
+    }
+
+    SDL_RenderFlush(m_renderer);
+
+    const auto blend = getSpanFunctions().blend;
+    uint32_t* target = getPixels();
+    const int pitch = getPitchPixels();
+    m_scratchRow.resize((size_t)visible.w);
+
+    for(int y = visible.y; y < visible.y + visible.h; y++)
+    {
+        // nearest neighbour scaling into a scratch row, which the span function then tints and blends in one pass
+        const int sourceY = source.y + (y - destination.y) * source.h / destination.h;
+        const uint32_t* sourceRow = pixels + sourceY * pitchPixels;
+        for(int x = 0; x < visible.w; x++)
+        {
+            m_scratchRow[(size_t)x] = sourceRow[source.x + (visible.x + x - destination.x) * source.w / destination.w];
+        }
+        blend(target + y * pitch + visible.x, m_scratchRow.data(), visible.w, tint);
+    }
+}
+
+void Framebuffer::present(const std::vector<SDL_Rect>& dirtyRects)
+{
+    SDL_RenderFlush(m_renderer);
+    if(m_windowRenderer == nullptr)
+    {
+        return;
+    }
+
+    // the window texture keeps its contents, so only the parts that changed are uploaded
+    for(const SDL_Rect& rect : dirtyRects)
+    {
+        const uint32_t* firstPixel = getPixels() + rect.y * getPitchPixels() + rect.x;
+        SDL_UpdateTexture(m_windowTexture, &rect, firstPixel, m_surface->pitch);
+    }
+    SDL_RenderCopy(m_windowRenderer, m_windowTexture, nullptr, nullptr);
+    SDL_RenderPresent(m_windowRenderer);
+}
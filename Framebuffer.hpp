@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+// Software render target: the frame is drawn on the CPU into a 32-bit ARGB pixel buffer and uploaded to the window
+// with SDL_UpdateTexture once per frame. Created without a window it is a headless renderer for tests and benchmarks.
+//
+// Rectangle fills and sprite blits go straight into the pixel buffer through SSE2/AVX2 span loops. Everything else
+// is drawn by an SDL software renderer targeting the same pixels, so drawing code works unchanged.
+class Framebuffer
+{
+public:
+    Framebuffer(SDL_Window* window, bool vsync = false);
+    Framebuffer(Framebuffer&) = delete;
+    Framebuffer& operator=(Framebuffer&) = delete;
+    ~Framebuffer();
+
+    SDL_Renderer* getRenderer() const
+    {
+        return m_renderer;
+    }
+    uint32_t* getPixels() const
+    {
+        return (uint32_t*)m_surface->pixels;
+    }
+    int getPitchPixels() const
+    {
+        return m_surface->pitch / (int)sizeof(uint32_t);
+    }
+
+    // these are clipped to the renderer's clip rectangle, and flush any queued SDL commands first to keep ordering
+    void fillRects(const SDL_Rect* rects, int count, const SDL_Color& color);
+    void drawPoints(const SDL_Point* points, int count, const SDL_Color& color);
+    void blit(
+        const uint32_t* pixels,
+        int pitchPixels,
+        const SDL_Rect& source,
+        const SDL_Rect& destination,
+        const SDL_Color& tint);
+
+    void present(const std::vector<SDL_Rect>& dirtyRects);
+
+private:
+    SDL_Rect getClipRect() const;
+
+private:
+    SDL_Surface* m_surface = nullptr;
+    SDL_Renderer* m_renderer = nullptr;
+
+    // only used when there is a window to present to
+    SDL_Renderer* m_windowRenderer = nullptr;
+    SDL_Texture* m_windowTexture = nullptr;
+
+    std::vector<uint32_t> m_scratchRow;
+};
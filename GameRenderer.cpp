@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <SDL.h>
+
+#include "GameRenderer.hpp"
+#include "Framebuffer.hpp"
+#include "GridObject.hpp"
+#include "Profiler.hpp"
+#include "font.hpp"
+#include "util.hpp"
+
+GameRenderer::GameRenderer(SDL_Renderer* renderer, Framebuffer* framebuffer)
+: m_renderer(renderer), m_framebuffer(framebuffer), m_drawBatch(renderer, framebuffer), m_atlas(m_drawBatch),
+  m_textCache(m_drawBatch, m_atlas)
+{
+    if(SDL_RenderTargetSupported(m_renderer))
+    {
+        m_boardTexture = SDL_CreateTexture(
+            m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+    if(m_boardTexture != nullptr)
+    {
+        // the board is opaque, so it can replace the screen contents without blending
+        SDL_SetTextureBlendMode(m_boardTexture, SDL_BLENDMODE_NONE);
+    }
+    else
+    {
+        LOG_WARN("Render targets unavailable, the board will be redrawn every frame");
+    }
+}
+
+GameRenderer::~GameRenderer()
+{
+    if(m_boardTexture != nullptr)
+    {
+        SDL_DestroyTexture(m_boardTexture);
+    }
+    if(m_backbuffer != nullptr)
+    {
+        SDL_DestroyTexture(m_backbuffer);
+    }
+}
+
+void GameRenderer::render(const FrameSnapshot& snapshot, uint64_t clockTime)
+{
+    PROFILE_ZONE("render");
+
+    // the snapshot may be a little old by now, so sprites are placed where they'd be between its tick and the next
+    const uint64_t tickLength = snapshot.nextTickTime - snapshot.tickTime;
+    m_interpolation = 0;
+    if(clockTime > snapshot.tickTime && tickLength > 0)
+    {
+        m_interpolation = (int)std::min<uint64_t>(
+            INTERPOLATION_SCALE, (clockTime - snapshot.tickTime) * INTERPOLATION_SCALE / tickLength);
+    }
+
+    updateBoardTexture(snapshot.board);
+
+    if(m_framebuffer != nullptr)
+    {
+        renderToFramebuffer(snapshot);
+        return;
+    }
+
+    if(!m_incrementalRendering)
+    {
+        SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0xff);
+        SDL_RenderClear(m_renderer);
+        drawScene(snapshot);
+        {
+            PROFILE_ZONE("batch submit");
+            m_drawBatch.flush();
+        }
+        if(m_profilerOverlay)
+        {
+            drawProfilerOverlay();
+        }
+        {
+            PROFILE_ZONE("present");
+            SDL_RenderPresent(m_renderer);
+        }
+        m_dirtyRegions.clear();
+        return;
+    }
+
+    markDirtyRegions(snapshot);
+
+    // the scene is batched once and submitted once per dirty rectangle, clipped to it, into the persistent backbuffer
+    SDL_SetRenderTarget(m_renderer, m_backbuffer);
+    drawScene(snapshot);
+    {
+        PROFILE_ZONE("batch submit");
+        for(const SDL_Rect& rect : m_dirtyRegions.getRects())
+        {
+            SDL_RenderSetClipRect(m_renderer, &rect);
+            m_drawBatch.submit();
+        }
+        m_drawBatch.clear();
+    }
+    SDL_RenderSetClipRect(m_renderer, nullptr);
+    SDL_SetRenderTarget(m_renderer, nullptr);
+    m_dirtyRegions.clear();
+
+    SDL_RenderCopy(m_renderer, m_backbuffer, nullptr, nullptr);
+    if(m_profilerOverlay)
+    {
+        drawProfilerOverlay();
+    }
+    PROFILE_ZONE("present");
+    SDL_RenderPresent(m_renderer);
+}
+
+void GameRenderer::renderToFramebuffer(const FrameSnapshot& snapshot)
+{
+    // the framebuffer keeps its contents between frames, so it doubles as the incremental mode backbuffer
+    if(m_incrementalRendering)
+    {
+        markDirtyRegions(snapshot);
+    }
+    else
+    {
+        m_dirtyRegions.addFullScreen();
+    }
+    if(m_profilerOverlay)
+    {
+        m_dirtyRegions.add(PROFILER_OVERLAY_REGION);
+    }
+
+    drawScene(snapshot);
+    {
+        PROFILE_ZONE("batch submit");
+        for(const SDL_Rect& rect : m_dirtyRegions.getRects())
+        {
+            SDL_RenderSetClipRect(m_renderer, &rect);
+            m_drawBatch.submit();
+        }
+        m_drawBatch.clear();
+    }
+    SDL_RenderSetClipRect(m_renderer, nullptr);
+    if(m_profilerOverlay)
+    {
+        drawProfilerOverlay();
+    }
+
+    PROFILE_ZONE("present");
+    m_framebuffer->present(m_dirtyRegions.getRects());
+    m_dirtyRegions.clear();
+}
+
+void GameRenderer::handleRenderTargetsReset()
+{
+    // the renderer may drop the contents of target textures, e.g. on a Direct3D device reset
+    m_boardTextureDirty = true;
+}
+
+void GameRenderer::setIncrementalRendering(bool enabled)
+{
+    if(enabled && m_backbuffer == nullptr && m_boardTexture != nullptr && m_framebuffer == nullptr)
+    {
+        m_backbuffer = SDL_CreateTexture(
+            m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if(m_backbuffer != nullptr)
+        {
+            SDL_SetTextureBlendMode(m_backbuffer, SDL_BLENDMODE_NONE);
+        }
+    }
+
+    if(enabled && m_backbuffer == nullptr && m_framebuffer == nullptr)
+    {
+        LOG_WARN("Incremental rendering needs render target support, drawing full frames");
+        return;
+    }
+
+    m_incrementalRendering = enabled;
+    m_dirtyRegions.addFullScreen();
+    LOG_INFO("Incremental rendering %s", enabled ? "enabled" : "disabled");
+}
+
+void GameRenderer::setProfilerOverlay(bool enabled)
+{
+#if PACMAN_PROFILER
+    m_profilerOverlay = enabled;
+    if(enabled)
+    {
+        Profiler::enable();
+    }
+
+    // the scene has to be redrawn where the overlay was
+    m_dirtyRegions.add(PROFILER_OVERLAY_REGION);
+#else
+    (void)enabled;
+    LOG_WARN("The profiler overlay needs a build with PACMAN_PROFILER on");
+#endif
+}
+
+void GameRenderer::drawProfilerOverlay()
+{
+    // a full height bar is a 30 fps frame, bars under the line made 60
+    static const float GRAPH_MAX_MS = 1000.0f / 30;
+    static const float TARGET_MS = 1000.0f / 60;
+    static const int TEXT_HEIGHT = 9;
+
+    const SDL_Rect& region = PROFILER_OVERLAY_REGION;
+    const int graphBottom = region.y + region.h - 2;
+    const int graphHeight = region.h - 2 * TEXT_HEIGHT - 4;
+    m_drawBatch.fillRect(region, COLOR_BLACK);
+
+    const std::vector<float>& frameMs = Profiler::getRecentFrameMs();
+    const size_t bars = std::min(frameMs.size(), (size_t)region.w - 4);
+    for(size_t bar = 0; bar < bars; bar++)
+    {
+        const float ms = frameMs[frameMs.size() - bars + bar];
+        const int height = std::clamp((int)(ms / GRAPH_MAX_MS * graphHeight), 1, graphHeight);
+        const SDL_Color& color = ms <= TARGET_MS + 1 ? COLOR_GREEN : ms <= GRAPH_MAX_MS + 1 ? COLOR_YELLOW : COLOR_RED;
+        m_drawBatch.fillRect({region.x + 2 + (int)bar, graphBottom - height, 1, height}, color);
+    }
+    const int targetY = graphBottom - (int)(TARGET_MS / GRAPH_MAX_MS * graphHeight);
+    m_drawBatch.drawLine(region.x + 2, targetY, region.x + region.w - 3, targetY, COLOR_BLUE);
+
+    const int fps = (int)(Profiler::getFramesPerSecond() + 0.5);
+    const int lastMs = frameMs.empty() ? 0 : (int)(frameMs.back() + 0.5f);
+    const int textX = region.x + 2;
+    drawStringGlyphs(m_atlas, textX, region.y + 2, "FPS " + std::to_string(fps), COLOR_WHITE, 1);
+    drawStringGlyphs(m_atlas, textX, region.y + 2 + TEXT_HEIGHT, "MS " + std::to_string(lastMs), COLOR_WHITE, 1);
+    m_drawBatch.flush();
+}
+
+void GameRenderer::markDirtyRegions(const FrameSnapshot& snapshot)
+{
+    m_drawnGhosts.resize(snapshot.ghosts.size(), {0, 0, 0, 0});
+    for(size_t ghostIndex = 0; ghostIndex < snapshot.ghosts.size(); ghostIndex++)
+    {
+        markSpriteDirty(snapshot.ghosts[ghostIndex], m_drawnGhosts[ghostIndex]);
+    }
+    markSpriteDirty(snapshot.pacman, m_drawnPacman);
+    markSpriteDirty(snapshot.fruit, m_drawnFruit);
+
+    // the HUD only changes when the values shown in it change
+    if(snapshot.score != m_drawnHud.score || snapshot.highScore != m_drawnHud.highScore)
+    {
+        m_dirtyRegions.add(HUD_SCORE_REGION);
+    }
+    if(snapshot.lives != m_drawnHud.lives || snapshot.level != m_drawnHud.level)
+    {
+        m_dirtyRegions.add(HUD_STATUS_REGION);
+    }
+    if(snapshot.readyDisplayed != m_drawnHud.readyDisplayed || snapshot.gameOver != m_drawnHud.gameOver)
+    {
+        m_dirtyRegions.add(HUD_BANNER_REGION);
+    }
+    m_drawnHud = {
+        snapshot.score,
+        snapshot.highScore,
+        snapshot.lives,
+        snapshot.level,
+        snapshot.readyDisplayed,
+        snapshot.gameOver};
+}
+
+void GameRenderer::markSpriteDirty(const SpriteSnapshot& sprite, SDL_Rect& drawnBounds)
+{
+    // both where the sprite was and where it will be need to be redrawn
+    m_dirtyRegions.add(drawnBounds);
+    drawnBounds = sprite.visible ? getDrawBounds(sprite) : SDL_Rect {0, 0, 0, 0};
+    m_dirtyRegions.add(drawnBounds);
+}
+
+SDL_Point GameRenderer::getDrawCenter(const SpriteSnapshot& sprite) const
+{
+    // jumps (wrapping through the tunnel, resets, leaving the box) snap rather than slide across the screen
+    const SDL_Point& from = sprite.previousCenter;
+    const SDL_Point& to = sprite.center;
+    if(abs(to.x - from.x) > TILE_WIDTH || abs(to.y - from.y) > TILE_HEIGHT)
+    {
+        return to;
+    }
+
+    return {
+        from.x + (to.x - from.x) * m_interpolation / INTERPOLATION_SCALE,
+        from.y + (to.y - from.y) * m_interpolation / INTERPOLATION_SCALE};
+}
+
+SDL_Rect GameRenderer::getDrawBounds(const SpriteSnapshot& sprite) const
+{
+    const SDL_Point center = getDrawCenter(sprite);
+    return {center.x - sprite.width / 2, center.y - sprite.height / 2, sprite.width, sprite.height};
+}
+
+void GameRenderer::drawScene(const FrameSnapshot& snapshot)
+{
+    {
+        PROFILE_ZONE("board draw");
+        drawFullBoard(snapshot.board);
+    }
+    drawScore(snapshot);
+
+    for(const SpriteSnapshot& displayFruit : snapshot.displayFruits)
+    {
+        m_atlas.drawFruit(displayFruit.center.x, displayFruit.center.y, displayFruit.frame);
+    }
+
+    if(snapshot.gameOver)
+    {
+        autoDisplayString(m_textCache, "GAME OVER", COLOR_YELLOW);
+        return;
+    }
+
+    if(snapshot.readyDisplayed)
+    {
+        autoDisplayString(m_textCache, "READY", COLOR_YELLOW);
+    }
+
+    static const int LIFE_DISPLAY_PADDING = 10;
+
+    for(int displayLife = 0; displayLife < snapshot.lives; displayLife++)
+    {
+        m_atlas.drawPacman(
+            X_CENTER(1 + displayLife) + LIFE_DISPLAY_PADDING * displayLife,
+            Y_CENTER(31),
+            Direction::LEFT,
+            Pacman::RADIUS);
+    }
+
+    // draw points claimable fruit if it is active
+    if(snapshot.fruit.visible)
+    {
+        const SDL_Point center = getDrawCenter(snapshot.fruit);
+        m_atlas.drawFruit(center.x, center.y, snapshot.fruit.frame);
+    }
+
+    // draw moving elements
+    if(snapshot.pacman.visible)
+    {
+        const SDL_Point center = getDrawCenter(snapshot.pacman);
+        m_atlas.drawPacman(center.x, center.y, snapshot.pacman.facingDirection, snapshot.pacman.frame);
+    }
+
+    for(const SpriteSnapshot& ghost : snapshot.ghosts)
+    {
+        if(ghost.visible)
+        {
+            const SDL_Point center = getDrawCenter(ghost);
+            m_atlas.drawGhost(center.x, center.y, ghost.color);
+        }
+    }
+}
+
+void GameRenderer::drawScore(const FrameSnapshot& snapshot)
+{
+    PROFILE_ZONE("HUD");
+    const int SCOREBOARD_TEXT_START_X = 150;
+    const int SCOREBOARD_TEXT_Y = 6;
+    const int SCOREBOARD_NUMBER_Y = 24;
+    const int CHAR_WIDTH = 16;
+    displayString(m_textCache, SCOREBOARD_TEXT_START_X, SCOREBOARD_TEXT_Y, "1 UP", COLOR_TURQUOISE);
+    displayNumber(
+        m_textCache, SCOREBOARD_TEXT_START_X + 4 * CHAR_WIDTH, SCOREBOARD_NUMBER_Y, snapshot.score, COLOR_WHITE);
+    displayString(m_textCache, SCOREBOARD_TEXT_START_X + 10 * CHAR_WIDTH, SCOREBOARD_TEXT_Y, "HIGH SCORE", COLOR_WHITE);
+    displayNumber(
+        m_textCache, SCOREBOARD_TEXT_START_X + 19 * CHAR_WIDTH, SCOREBOARD_NUMBER_Y, snapshot.highScore, COLOR_WHITE);
+}
+
+void GameRenderer::updateBoardTexture(const Bitboard& board)
+{
+    PROFILE_ZONE("board texture");
+    // eaten dots are erased tile by tile, any other change (a new level) redraws the whole board
+    bool rebuild = m_boardTextureDirty || board.getRows() != m_drawnBoard.getRows()
+        || board.getCols() != m_drawnBoard.getCols();
+    bool erased = false;
+    for(int row = 0; !rebuild && row < board.getRows(); row++)
+    {
+        const uint32_t dots = board.getDotRow(row);
+        const uint32_t superDots = board.getSuperDotRow(row);
+        const uint32_t drawnDots = m_drawnBoard.getDotRow(row);
+        const uint32_t drawnSuperDots = m_drawnBoard.getSuperDotRow(row);
+        const bool wallsChanged = board.getWallRow(row) != m_drawnBoard.getWallRow(row)
+            || board.getWrapRow(row) != m_drawnBoard.getWrapRow(row);
+        if(wallsChanged || (dots & ~drawnDots) != 0 || (superDots & ~drawnSuperDots) != 0)
+        {
+            rebuild = true;
+            break;
+        }
+
+        uint32_t eaten = (drawnDots & ~dots) | (drawnSuperDots & ~superDots);
+        for(int col = 0; eaten != 0; col++, eaten >>= 1)
+        {
+            if((eaten & 1) == 0)
+            {
+                continue;
+            }
+            SDL_Rect tile = {col * TILE_WIDTH, row * TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT};
+            m_drawBatch.fillRect(tile, COLOR_BLACK);
+            m_dirtyRegions.add(tile);
+            erased = true;
+        }
+    }
+
+    if(!rebuild && !erased)
+    {
+        return;
+    }
+    m_drawnBoard = board;
+
+    if(rebuild)
+    {
+        // anything queued for erasing gets redrawn anyway
+        m_drawBatch.clear();
+        m_dirtyRegions.addFullScreen();
+    }
+
+    if(m_boardTexture == nullptr)
+    {
+        // the board is drawn with the rest of the scene instead
+        m_drawBatch.clear();
+        m_boardTextureDirty = false;
+        return;
+    }
+
+    SDL_SetRenderTarget(m_renderer, m_boardTexture);
+    if(rebuild)
+    {
+        SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+        SDL_RenderClear(m_renderer);
+        drawBoardTiles(board);
+        m_boardTextureDirty = false;
+    }
+    m_drawBatch.flush();
+    SDL_SetRenderTarget(m_renderer, nullptr);
+}
+
+void GameRenderer::drawFullBoard(const Bitboard& board)
+{
+    const SDL_Rect screen = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+    if(m_boardTexture == nullptr)
+    {
+        // primitives are submitted first, so this clears behind the whole scene
+        m_drawBatch.fillRect(screen, COLOR_BLACK);
+        drawBoardTiles(board);
+        return;
+    }
+
+    m_drawBatch.copy(m_boardTexture, screen, screen, COLOR_WHITE);
+}
+
+void GameRenderer::drawBoardTiles(const Bitboard& board)
+{
+    for(int row = 0; row < board.getRows(); row++)
+    {
+        for(int col = 0; col < board.getCols(); col++)
+        {
+            int rowCenter = Y_CENTER(row);
+            int colCenter = X_CENTER(col);
+            switch(board.getTile(row, col))
+            {
+            case DOT:
+                drawFilledCircle(m_drawBatch, colCenter, rowCenter, 4, COLOR_WHITE);
+                break;
+            case SUPER_DOT:
+                drawFilledCircle(m_drawBatch, colCenter, rowCenter, 8, COLOR_WHITE);
+                break;
+            case BOUNDARY:
+                drawBoundary(board, row, col);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+void GameRenderer::drawBoundary(const Bitboard& board, int row, int col)
+{
+    for(size_t dir = 0; dir < (size_t)Direction::MAX; dir++)
+    {
+        int adjRow = row + Y_INCREMENT[dir];
+        int adjCol = col + X_INCREMENT[dir];
+        if(board.isWall(adjRow, adjCol))
+        {
+            m_drawBatch.drawLine(X_CENTER(adjCol), Y_CENTER(adjRow), X_CENTER(col), Y_CENTER(row), COLOR_WHITE);
+        }
+    }
+}
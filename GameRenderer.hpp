@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+#include "DirtyRegions.hpp"
+#include "DrawBatch.hpp"
+#include "FrameRenderer.hpp"
+#include "FrameSnapshot.hpp"
+#include "SpriteAtlas.hpp"
+#include "TextCache.hpp"
+#include "util.hpp"
+
+// forward declaration
+class Framebuffer;
+
+// Draws frames from simulation snapshots. It only reads the snapshot it's given, so it can run on a different thread
+// from the simulation, which never waits for it.
+class GameRenderer : public FrameRenderer
+{
+public:
+    GameRenderer(SDL_Renderer* renderer, Framebuffer* framebuffer = nullptr);
+    GameRenderer(GameRenderer&) = delete;
+    GameRenderer& operator=(GameRenderer&) = delete;
+    ~GameRenderer();
+
+    void render(const FrameSnapshot& snapshot, uint64_t clockTime) override;
+    void handleRenderTargetsReset();
+    void setIncrementalRendering(bool enabled);
+
+    // FPS and a graph of recent frame times in the top left corner
+    void setProfilerOverlay(bool enabled);
+    bool isProfilerOverlayEnabled() const
+    {
+        return m_profilerOverlay;
+    }
+
+private:
+    void renderToFramebuffer(const FrameSnapshot& snapshot);
+    void markDirtyRegions(const FrameSnapshot& snapshot);
+    void markSpriteDirty(const SpriteSnapshot& sprite, SDL_Rect& drawnBounds);
+    void drawScene(const FrameSnapshot& snapshot);
+    void drawScore(const FrameSnapshot& snapshot);
+    void updateBoardTexture(const Bitboard& board);
+    void drawFullBoard(const Bitboard& board);
+    void drawBoardTiles(const Bitboard& board);
+    void drawBoundary(const Bitboard& board, int row, int col);
+    SDL_Point getDrawCenter(const SpriteSnapshot& sprite) const;
+    SDL_Rect getDrawBounds(const SpriteSnapshot& sprite) const;
+    void drawProfilerOverlay();
+
+private:
+    static inline const int INTERPOLATION_SCALE = 256;
+
+    SDL_Renderer* m_renderer;
+    Framebuffer* m_framebuffer;
+    DrawBatch m_drawBatch;
+    SpriteAtlas m_atlas;
+    TextCache m_textCache;
+
+    // progress from the snapshot's tick towards the next one, out of INTERPOLATION_SCALE
+    int m_interpolation = 0;
+
+    // walls and dots are drawn once into this texture, eaten dots are erased tile by tile
+    SDL_Texture* m_boardTexture = nullptr;
+    bool m_boardTextureDirty = true;
+    Bitboard m_drawnBoard; // what the board texture currently shows
+
+    // incremental mode only redraws the dirty regions of a persistent backbuffer (or of the framebuffer)
+    struct HudState
+    {
+        int score;
+        int highScore;
+        int lives;
+        int level;
+        bool readyDisplayed;
+        bool gameOver;
+    };
+
+    static inline const SDL_Rect HUD_SCORE_REGION = {0, 24, SCREEN_WIDTH, 14};
+    static inline const SDL_Rect HUD_STATUS_REGION = {0, 31 * TILE_HEIGHT, SCREEN_WIDTH, TILE_HEIGHT};
+    static inline const SDL_Rect HUD_BANNER_REGION = {0, 550, SCREEN_WIDTH, 14};
+
+    bool m_incrementalRendering = false;
+    SDL_Texture* m_backbuffer = nullptr;
+    DirtyRegions m_dirtyRegions;
+    HudState m_drawnHud = {};
+
+    // drawn over the finished frame, so only the framebuffer, which keeps its contents, has to repaint beneath it
+    static inline const SDL_Rect PROFILER_OVERLAY_REGION = {4, 4, 128, 64};
+    bool m_profilerOverlay = false;
+
+    // where each moving sprite was on screen as of the last frame
+    SDL_Rect m_drawnPacman = {0, 0, 0, 0};
+    SDL_Rect m_drawnFruit = {0, 0, 0, 0};
+    std::vector<SDL_Rect> m_drawnGhosts;
+
+    friend class Benchmarks; // pacman_bench.cpp times the drawing steps on their own
+};
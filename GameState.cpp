@@ -1,39 +1,62 @@
+#include <algorithm>
 #include <SDL.h>
 
 #include "GameState.hpp"
-#include "font.hpp"
+#include "Profiler.hpp"
 #include "TimerService.hpp"
 #include "util.hpp"
 
-GameState::GameState(SDL_Renderer* renderer) : m_renderer(renderer)
+// trace event names for each direction, released then pressed
+static const char* const INPUT_TRACE_NAMES[(size_t)Direction::MAX][2] = {
+    {"input UP released", "input UP pressed"},
+    {"input DOWN released", "input DOWN pressed"},
+    {"input LEFT released", "input LEFT pressed"},
+    {"input RIGHT released", "input RIGHT pressed"}};
+
+GameState::GameState(std::unique_ptr<Clock> clock) : m_clock(std::move(clock))
 {
     LOG_INFO("Constructing GameState");
 
-    auto& timerService = TimerService::getInstance();
+    resetBoard();
 
-    size_t readyTimerKey = timerService.addTimer(
-        readyTimerLengthTicks,
-        false,
-        [this]()
-        {
-            m_readyDisplayed = false;
-            m_activePlay = true;
-            m_pacman.reset();
-            for(auto& ghost : m_ghosts)
-            {
-                ghost->resetChaseState();
-            }
-        });
-    timerService.startTimer(readyTimerKey);
+    m_readyTimer = m_timerService.addTimer(readyTimerLengthTicks, false, [this]() { startPlay(); }, &m_gameTimers);
+    m_readyTimer.start();
 }
 
-void GameState::update()
+void GameState::startPlay()
 {
+    m_readyDisplayed = false;
+    m_activePlay = true;
+    m_pacman.reset();
+    for(auto& ghost : m_ghosts)
+    {
+        ghost->resetChaseState();
+    }
+}
+
+void GameState::tick()
+{
+    PROFILE_ZONE("tick");
+    m_simulationTicks++;
+
+    // interpolation starts from where everything was before this tick
+    m_pacman.savePreviousPosition();
+    for(auto& ghost : m_ghosts)
+    {
+        ghost->savePreviousPosition();
+    }
+    m_fruit.savePreviousPosition();
+
     // handle moving to next level
-    if(m_dotsRemaining <= 0)
+    if(m_board.getDotCount() <= 0)
     {
         m_level++;
-        m_board = BASE_LAYOUT;
+        resetBoard();
+
+        // nothing from the last level carries over
+        m_levelTimers.stopAll();
+        m_fruit.reset();
+        TRACE_INSTANT("level", m_level);
         LOG_INFO("Level: %d", m_level);
     }
 
@@ -49,24 +72,38 @@ void GameState::update()
         m_highScore = m_score;
     }
 
-    // draw stationary elements
-    SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0xff);
-    SDL_RenderClear(m_renderer);
-    drawScore();
-    drawFullBoard();
-
-    for(size_t levelFruitIndex = 0; levelFruitIndex < m_level; levelFruitIndex++)
+    if(!gameOver())
     {
-        size_t index = levelFruitIndex >= m_displayFruits.size() ? (m_displayFruits.size() - 1) : levelFruitIndex;
-        m_displayFruits[index].update();
-    }
+        checkCollisions();
 
-    if(gameOver())
-    {
-        autoDisplayString(m_renderer, "GAME OVER", COLOR_YELLOW);
-        goto finishRender;
+        {
+            PROFILE_ZONE("checkTimers");
+            m_timerService.checkTimers(getSimulationTimeMs());
+        }
+
+        {
+            PROFILE_ZONE("fruit update");
+            m_fruit.update();
+        }
+
+        // move the moving elements
+        if(m_activePlay)
+        {
+            PROFILE_ZONE("pacman update");
+            m_pacman.update();
+        }
+
+        for(auto& ghost : m_ghosts)
+        {
+            PROFILE_ZONE("ghost update");
+            ghost->update();
+        }
     }
+}
 
+void GameState::checkCollisions()
+{
+    PROFILE_ZONE("collisions");
     for(auto& ghost : m_ghosts)
     {
         if(ghost->hasSamePositionAs(m_pacman))
@@ -81,6 +118,7 @@ void GameState::update()
             {
                 LOG_INFO("Found a ghost, lose a life: %d -> %d", m_lives, m_lives - 1);
                 m_lives--;
+                TRACE_INSTANT("life lost", m_lives);
 
                 m_pacman.reset();
                 for(auto& ghost : m_ghosts)
@@ -90,66 +128,169 @@ void GameState::update()
             }
         }
     }
+}
 
-    TimerService::getInstance().checkTimers();
+uint64_t GameState::getSimulationTimeMs() const
+{
+    return m_simulationTicks * 1000 / TICKS_PER_SECOND;
+}
 
-    if(m_readyDisplayed)
+void GameState::handleInput(const InputEvent& input)
+{
+    TRACE_INSTANT(INPUT_TRACE_NAMES[(size_t)input.direction][input.pressed], m_simulationTicks);
+    m_heldDirections[(size_t)input.direction] = input.pressed;
+    if(input.pressed)
     {
-        autoDisplayString(m_renderer, "READY", COLOR_YELLOW);
+        m_pacman.changeDirection(input.direction);
     }
+}
+
+void GameState::fillSnapshot(FrameSnapshot& snapshot) const
+{
+    snapshot.tick = m_simulationTicks;
+    snapshot.board = m_board;
 
-    static const int LIFE_DISPLAY_PADDING = 10;
+    const bool playing = !gameOver();
+    m_pacman.fillSnapshot(snapshot.pacman);
+    snapshot.pacman.visible = playing && m_activePlay;
 
-    for(int displayLife = 0; displayLife < m_lives; displayLife++)
+    snapshot.ghosts.resize(m_ghosts.size());
+    for(size_t ghostIndex = 0; ghostIndex < m_ghosts.size(); ghostIndex++)
     {
-        Pacman::drawPacman(
-            m_renderer,
-            X_CENTER(1 + displayLife) + LIFE_DISPLAY_PADDING * displayLife,
-            Y_CENTER(31),
-            Direction::LEFT,
-            Pacman::RADIUS);
+        m_ghosts[ghostIndex]->fillSnapshot(snapshot.ghosts[ghostIndex]);
+        snapshot.ghosts[ghostIndex].visible = playing;
     }
 
-    // draw points claimable fruit if it is active
-    m_fruit.update();
+    m_fruit.fillSnapshot(snapshot.fruit);
+    snapshot.fruit.visible = playing && m_fruit.isActive();
 
-    // draw moving elements
-    if(m_activePlay)
+    // levels past the last fruit keep showing the last one
+    snapshot.displayFruits.resize(std::min((size_t)m_level, m_displayFruits.size()));
+    for(size_t fruitIndex = 0; fruitIndex < snapshot.displayFruits.size(); fruitIndex++)
     {
-        m_pacman.update();
+        m_displayFruits[fruitIndex].fillSnapshot(snapshot.displayFruits[fruitIndex]);
+        snapshot.displayFruits[fruitIndex].visible = true;
     }
 
-    for(auto& ghost : m_ghosts)
+    snapshot.score = m_score;
+    snapshot.highScore = m_highScore;
+    snapshot.lives = m_lives;
+    snapshot.level = m_level;
+    snapshot.readyDisplayed = m_readyDisplayed;
+    snapshot.gameOver = !playing;
+}
+
+uint64_t GameState::computeStateHash() const
+{
+    StateHash hash;
+    hash.add(m_simulationTicks);
+    m_board.hashState(hash);
+
+    m_pacman.hashState(hash);
+    for(const auto& ghost : m_ghosts)
     {
-        ghost->update();
+        ghost->hashState(hash);
+    }
+    m_fruit.hashState(hash);
+
+    hash.add(m_readyDisplayed);
+    hash.add(m_activePlay);
+    hash.add(m_flashingGhostPoints);
+    hash.add(m_highScore);
+    hash.add(m_score);
+    hash.add(m_lives);
+    hash.add(m_level);
+    hash.add(m_extraLifeThreshold);
+    hash.add(m_dotsEaten);
+    hash.add(m_fruitThreshold);
+    hash.add(m_fruitPoints);
+    for(const bool held : m_heldDirections)
+    {
+        hash.add(held);
     }
 
-finishRender:
-    SDL_RenderPresent(m_renderer);
+    m_timerService.hashState(hash);
+    return hash.get();
 }
 
-void GameState::handleKeypress(const SDL_Keycode keyCode)
+void GameState::saveState(std::vector<uint8_t>& bytes) const
 {
-    switch(keyCode)
+    StateWriter writer(bytes);
+    writer.write(m_simulationTicks);
+    m_board.saveState(writer);
+
+    writer.write(m_readyDisplayed);
+    writer.write(m_activePlay);
+    writer.write(m_flashingGhostPoints);
+    writer.write(m_highScore);
+    writer.write(m_score);
+    writer.write(m_lives);
+    writer.write(m_level);
+    writer.write(m_extraLifeThreshold);
+    writer.write(m_dotsEaten);
+    writer.write(m_fruitThreshold);
+    writer.write(m_fruitPoints);
+    for(const bool held : m_heldDirections)
     {
-    case SDLK_UP:
-        m_pacman.changeDirection(Direction::UP);
-        break;
-    case SDLK_DOWN:
-        m_pacman.changeDirection(Direction::DOWN);
-        break;
-    case SDLK_LEFT:
-        m_pacman.changeDirection(Direction::LEFT);
-        break;
-    case SDLK_RIGHT:
-        m_pacman.changeDirection(Direction::RIGHT);
-        break;
-    default:
-        LOG_WARN("Unsupported keypress %d", keyCode);
+        writer.write(held);
     }
+
+    // the timer service first, so restoring it clears out the old timers before the objects add theirs back
+    m_timerService.saveState(writer);
+    m_readyTimer.save(writer);
+
+    m_pacman.saveState(writer);
+    for(const auto& ghost : m_ghosts)
+    {
+        ghost->saveState(writer);
+    }
+    m_fruit.saveState(writer);
 }
 
-bool GameState::gameOver()
+bool GameState::restoreState(const uint8_t* data, size_t size)
+{
+    StateReader reader(data, size);
+    reader.read(m_simulationTicks);
+    if(!m_board.restoreState(reader))
+    {
+        return false;
+    }
+
+    reader.read(m_readyDisplayed);
+    reader.read(m_activePlay);
+    reader.read(m_flashingGhostPoints);
+    reader.read(m_highScore);
+    reader.read(m_score);
+    reader.read(m_lives);
+    reader.read(m_level);
+    reader.read(m_extraLifeThreshold);
+    reader.read(m_dotsEaten);
+    reader.read(m_fruitThreshold);
+    reader.read(m_fruitPoints);
+    for(bool& held : m_heldDirections)
+    {
+        reader.read(held);
+    }
+
+    m_timerService.restoreState(reader);
+    m_readyTimer.restore(reader, m_timerService, [this]() { startPlay(); }, &m_gameTimers);
+
+    m_pacman.restoreState(reader);
+    for(auto& ghost : m_ghosts)
+    {
+        ghost->restoreState(reader);
+    }
+    m_fruit.restoreState(reader);
+
+    if(reader.failed())
+    {
+        LOG_ERROR("Saved state is truncated");
+        return false;
+    }
+    return true;
+}
+
+bool GameState::gameOver() const
 {
     return m_lives <= 0;
 }
@@ -157,19 +298,14 @@ bool GameState::gameOver()
 void GameState::handlePacmanArrival()
 {
     // if a key is being held down, attempt to handle it
-    // the main loop handles the direction change if pacman is stopped
-    int numKeys = 0;
-    const uint8_t* const keys = SDL_GetKeyboardState(&numKeys);
-    if(numKeys > 0)
+    // key repeats handle the direction change if pacman is stopped
+    for(size_t direction = 0; direction < (size_t)Direction::MAX; direction++)
     {
-        if(keys[SDL_SCANCODE_UP])
-            m_pacman.changeDirection(Direction::UP);
-        else if(keys[SDL_SCANCODE_DOWN])
-            m_pacman.changeDirection(Direction::DOWN);
-        else if(keys[SDL_SCANCODE_LEFT])
-            m_pacman.changeDirection(Direction::LEFT);
-        else if(keys[SDL_SCANCODE_RIGHT])
-            m_pacman.changeDirection(Direction::RIGHT);
+        if(m_heldDirections[direction])
+        {
+            m_pacman.changeDirection((Direction)direction);
+            break;
+        }
     }
 
     if(m_fruit.isActive() && m_pacman.hasSamePositionAs(m_fruit))
@@ -180,24 +316,23 @@ void GameState::handlePacmanArrival()
     }
 
     auto [row, col] = m_pacman.getPosition();
-    auto& pacmansTile = m_board[row][col];
-    switch(pacmansTile)
+    switch(m_board.getTile(row, col))
     {
     case DOT:
         m_score += m_normalDotPoints;
         m_dotsEaten++;
-        pacmansTile = ' ';
+        m_board.eatDot(row, col);
         break;
     case SUPER_DOT:
         m_score += m_superDotPoints;
-        pacmansTile = ' ';
+        m_board.eatDot(row, col);
         for(auto& ghost : m_ghosts)
         {
             ghost->handleSuperDot();
         }
         break;
     case WRAP:
-        m_pacman.relocate(row, (int)m_board[0].size() - col - 1);
+        m_pacman.relocate(row, m_board.getCols() - col - 1);
         break;
     default:
         return;
@@ -212,71 +347,9 @@ void GameState::handlePacmanArrival()
     LOG_INFO("Score: %d", m_score);
 }
 
-void GameState::drawScore()
-{
-    const int SCOREBOARD_TEXT_START_X = 150;
-    const int SCOREBOARD_TEXT_Y = 6;
-    const int SCOREBOARD_NUMBER_Y = 24;
-    const int CHAR_WIDTH = 16;
-    displayString(m_renderer, SCOREBOARD_TEXT_START_X, SCOREBOARD_TEXT_Y, "1 UP", COLOR_TURQUOISE);
-    displayNumber(m_renderer, SCOREBOARD_TEXT_START_X + 4 * CHAR_WIDTH, SCOREBOARD_NUMBER_Y, m_score, COLOR_WHITE);
-    displayString(m_renderer, SCOREBOARD_TEXT_START_X + 10 * CHAR_WIDTH, SCOREBOARD_TEXT_Y, "HIGH SCORE", COLOR_WHITE);
-    displayNumber(m_renderer, SCOREBOARD_TEXT_START_X + 19 * CHAR_WIDTH, SCOREBOARD_NUMBER_Y, m_highScore, COLOR_WHITE);
-}
-
-void GameState::drawFullBoard()
-{
-    m_dotsRemaining = 0;
-    SDL_SetRenderDrawColor(m_renderer, 0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE);
-    for(int row = 0; row < (int)m_board.size(); row++)
-    {
-        for(int col = 0; col < (int)m_board[row].size(); col++)
-        {
-            int rowCenter = Y_CENTER(row);
-            int colCenter = X_CENTER(col);
-            switch(m_board[row][col])
-            {
-            case DOT:
-                drawFilledCircle(m_renderer, colCenter, rowCenter, 4, {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE});
-                m_dotsRemaining++;
-                break;
-            case SUPER_DOT:
-                m_dotsRemaining++;
-                drawFilledCircle(m_renderer, colCenter, rowCenter, 8, {0xff, 0xff, 0xff, SDL_ALPHA_OPAQUE});
-                break;
-            case BOUNDARY:
-                drawBoundary(row, col);
-                break;
-            default:
-                break;
-            }
-        }
-    }
-}
-
-void GameState::drawBoundary(int row, int col)
+void GameState::resetBoard()
 {
-    std::vector<Direction> edges;
-
-    for(size_t dir = 0; dir < (size_t)Direction::MAX; dir++)
-    {
-        int adjRow = row + Y_INCREMENT[dir];
-        int adjCol = col + X_INCREMENT[dir];
-        if(adjRow < 0 || adjRow >= m_board.size() || adjCol < 0 || adjCol >= m_board[adjRow].size())
-        {
-            continue;
-        }
-
-        if(m_board[adjRow][adjCol] == BOUNDARY)
-        {
-            edges.push_back((Direction)dir);
-        }
-    }
-
-    for(Direction dir : edges)
-    {
-        int xInc = X_INCREMENT[(size_t)dir];
-        int yInc = Y_INCREMENT[(size_t)dir];
-        SDL_RenderDrawLine(m_renderer, X_CENTER(col + xInc), Y_CENTER(row + yInc), X_CENTER(col), Y_CENTER(row));
-    }
+    // dots and all, the board every level starts from
+    static const Bitboard STARTING_BOARD(BASE_LAYOUT);
+    m_board = STARTING_BOARD;
 }
@@ -2,33 +2,76 @@
 
 #include <array>
 #include <memory>
-#include <optional>
 #include <string>
 #include <vector>
 
+#include "Bitboard.hpp"
+#include "Clock.hpp"
+#include "FrameSnapshot.hpp"
 #include "GridObject.hpp"
+#include "MazeGraph.hpp"
+#include "Navigation.hpp"
 #include "util.hpp"
 
-// forward declaration
-struct SDL_Renderer;
+// a direction key going down or up, the simulation only sees input through these
+struct InputEvent
+{
+    Direction direction;
+    bool pressed;
+};
 
+// The simulation: board, movers, timers and scoring, advanced in fixed ticks. It never draws; after a tick the state
+// the renderer needs is copied out with fillSnapshot.
+// Game time only advances with ticks. The clock it owns is what whoever runs the ticks paces them by; it defaults to
+// real time.
 class GameState
 {
 public:
-    GameState(SDL_Renderer* renderer);
+    static inline const int TICKS_PER_SECOND = 120;
+
+    GameState(std::unique_ptr<Clock> clock = std::make_unique<RealTimeClock>());
+    GameState(GameState&) = delete;
+    GameState& operator=(GameState&) = delete;
+
+    void tick();
+    void handleInput(const InputEvent& input);
+    void fillSnapshot(FrameSnapshot& snapshot) const;
+
+    // hash of everything that decides how the game plays out from here: board, movers, scoring and timers
+    uint64_t computeStateHash() const;
 
-    void update();
-    void handleKeypress(const SDL_Keycode keyCode);
-    bool gameOver();
+    // everything computeStateHash covers, for replay keyframes, restoring also replaces all the timers
+    void saveState(std::vector<uint8_t>& bytes) const;
+    bool restoreState(const uint8_t* data, size_t size);
+
+    bool gameOver() const;
     void handlePacmanArrival();
+    Clock& getClock() const
+    {
+        return *m_clock;
+    }
+    const TimerService& getTimerService() const
+    {
+        return m_timerService;
+    }
 
 private:
-    void drawScore();
-    void drawFullBoard();
-    void drawBoundary(int row, int col);
+    uint64_t getSimulationTimeMs() const;
+    void resetBoard();
+    void startPlay();
+    void checkCollisions();
 
 private:
-    BoardLayout m_board = BASE_LAYOUT;
+    std::unique_ptr<Clock> m_clock;
+
+    // declared before the objects so their timers can go in these groups, and outlive them
+    TimerService m_timerService;
+    TimerGroup m_gameTimers {m_timerService};
+    TimerGroup m_levelTimers {m_timerService, &m_gameTimers};
+
+    Bitboard m_board {BASE_LAYOUT};
+    std::shared_ptr<const MazeGraph> m_maze {MazeGraph::get(BASE_LAYOUT)};
+    std::shared_ptr<const NavigationTable> m_navigation {NavigationTable::get(BASE_LAYOUT)};
     Pacman m_pacman {*this};
     std::vector<std::unique_ptr<Ghost>> m_ghosts {Ghost::makeGhosts(*this)};
     PointsFruit m_fruit {*this};
@@ -38,6 +81,7 @@ private:
     bool m_activePlay = false;
 
     uint64_t readyTimerLengthTicks = 3000;
+    TimerHandle m_readyTimer;
 
     static const inline int DEFAULT_FLASHING_GHOST_POINTS = 100;
     int m_flashingGhostPoints = DEFAULT_FLASHING_GHOST_POINTS;
@@ -51,7 +95,6 @@ private:
     int m_score = 0;
     int m_lives = 3;
     int m_level = 1;
-    int m_dotsRemaining = 1;
     int m_extraLifeThreshold = 10'000;
     int m_extraLivesIncrement = 10'000;
 
@@ -62,7 +105,10 @@ private:
     int m_fruitPoints = 100;
     int m_fruitPointsMultiplier = 2;
 
-    SDL_Renderer* m_renderer;
+    uint64_t m_simulationTicks = 0;
+
+    // direction keys currently held down, tried in order whenever pacman reaches a tile
+    std::array<bool, (size_t)Direction::MAX> m_heldDirections = {};
 
     friend class Mover;
     friend class Pacman;
@@ -73,4 +119,5 @@ private:
     friend class Clyde;
     friend class DisplayFruit;
     friend class PointsFruit;
+    friend class Benchmarks; // pacman_bench.cpp
 };
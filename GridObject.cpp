@@ -1,9 +1,11 @@
 #include "GameState.hpp"
 #include "GridObject.hpp"
+#include "Spans.hpp"
 #include "TimerService.hpp"
 #include "util.hpp"
 
-GridObject::GridObject(GameState& gameState, int row, int col) : m_row(row), m_col(col), m_gameState(gameState)
+GridObject::GridObject(GameState& gameState, int row, int col)
+: m_row(row), m_col(col), m_previousCenter {X_CENTER(col), Y_CENTER(row)}, m_gameState(gameState)
 {
 }
 
@@ -18,10 +20,82 @@ void GridObject::relocate(int row, int col)
     m_col = col;
 }
 
+SDL_Point GridObject::getPixelCenter() const
+{
+    return {X_CENTER(m_col) + m_xPixelOffset, Y_CENTER(m_row) + m_yPixelOffset};
+}
+
+void GridObject::savePreviousPosition()
+{
+    m_previousCenter = getPixelCenter();
+}
+
+void GridObject::fillSnapshot(SpriteSnapshot& sprite) const
+{
+    sprite.previousCenter = m_previousCenter;
+    sprite.center = getPixelCenter();
+    sprite.width = m_spriteWidth;
+    sprite.height = m_spriteHeight;
+}
+
+void GridObject::hashState(StateHash& hash) const
+{
+    hash.add(m_row);
+    hash.add(m_col);
+    hash.add(m_xPixelOffset);
+    hash.add(m_yPixelOffset);
+}
+
+void GridObject::saveState(StateWriter& writer) const
+{
+    writer.write(m_row);
+    writer.write(m_col);
+    writer.write(m_xPixelOffset);
+    writer.write(m_yPixelOffset);
+    writer.write(m_previousCenter.x);
+    writer.write(m_previousCenter.y);
+}
+
+void GridObject::restoreState(StateReader& reader)
+{
+    reader.read(m_row);
+    reader.read(m_col);
+    reader.read(m_xPixelOffset);
+    reader.read(m_yPixelOffset);
+    reader.read(m_previousCenter.x);
+    reader.read(m_previousCenter.y);
+}
+
 Mover::Mover(GameState& gameState, int startRow, int startCol, Direction startFacing)
 : GridObject(gameState, startRow, startCol), m_facingDirection(startFacing)
 {
-    m_lastDrawnTicks = SDL_GetTicks64();
+}
+
+void Mover::hashState(StateHash& hash) const
+{
+    GridObject::hashState(hash);
+    hash.add(m_facingDirection);
+    hash.add(m_pendingDirection);
+    hash.add(m_subPixels);
+    hash.add(m_velocity);
+}
+
+void Mover::saveState(StateWriter& writer) const
+{
+    GridObject::saveState(writer);
+    writer.write(m_facingDirection);
+    writer.write(m_pendingDirection);
+    writer.write(m_subPixels);
+    writer.write(m_velocity);
+}
+
+void Mover::restoreState(StateReader& reader)
+{
+    GridObject::restoreState(reader);
+    reader.read(m_facingDirection);
+    reader.read(m_pendingDirection);
+    reader.read(m_subPixels);
+    reader.read(m_velocity);
 }
 
 void Mover::changeDirection(Direction newDirection)
@@ -45,14 +119,15 @@ void Mover::changeDirection(Direction newDirection)
 
 void Mover::handleMovement()
 {
-    uint64_t currentTicks = SDL_GetTicks64();
-    int numPixelsToMove = (int)(currentTicks - m_lastDrawnTicks) * m_velocity / 1000;
+    // called once per tick, whole pixels are moved and the remainder carries over to the next tick
+    m_subPixels += m_velocity;
+    int numPixelsToMove = m_subPixels / GameState::TICKS_PER_SECOND;
+    m_subPixels %= GameState::TICKS_PER_SECOND;
     if(numPixelsToMove == 0)
     {
         // no changes would take place if there is no velocity
         return;
     }
-    m_lastDrawnTicks = currentTicks;
 
     int xIncrement = X_INCREMENT[(size_t)m_facingDirection];
     int yIncrement = Y_INCREMENT[(size_t)m_facingDirection];
@@ -65,7 +140,7 @@ void Mover::handleMovement()
     int minYOffset = -TILE_HEIGHT / 2;
     int maxYOffset = TILE_HEIGHT / 2;
 
-    if(m_gameState.m_board[nextRow][nextCol] == BOUNDARY)
+    if(!m_gameState.m_maze->canMove(m_row, m_col, m_facingDirection))
     {
         // restrict movement to the center of the last tile before a boundary
         if(xIncrement == -1)
@@ -115,7 +190,7 @@ void Mover::handleMovement()
         return;
     }
 
-    if(m_gameState.m_board[nextRow][nextCol] == BOUNDARY)
+    if(!m_gameState.m_maze->canMove(m_row, m_col, m_facingDirection))
     {
         m_xPixelOffset = 0;
         m_yPixelOffset = 0;
@@ -135,62 +210,37 @@ void Mover::handleMovement()
 
 bool Mover::directionValid(const Direction newDirection) const
 {
-    int newRow = m_row + Y_INCREMENT[(size_t)newDirection];
-    int newCol = m_col + X_INCREMENT[(size_t)newDirection];
-    return m_gameState.m_board[newRow][newCol] != BOUNDARY;
-}
-
-bool Mover::directionIsCloser(const Direction newDirection, const GridPosition& otherPosition) const
-{
-    const size_t newDirIndex = (size_t)newDirection;
-    return abs(m_row + Y_INCREMENT[newDirIndex] - otherPosition.row) < abs(m_row - otherPosition.row)
-           || abs(m_col + X_INCREMENT[newDirIndex] - otherPosition.col) < abs(m_col - otherPosition.col);
+    // off the board counts as a wall, a mover turning back just after wrapping can get to the edge of it
+    return m_gameState.m_maze->canMove(m_row, m_col, newDirection);
 }
 
-void Pacman::drawPacman(
-    SDL_Renderer* renderer,
-    const int xCenter,
-    const int yCenter,
-    const Direction facingDirection,
-    const int mouthPixels)
+SpriteCanvas Pacman::rasterizeSprite(const Direction facingDirection, const int mouthPixels)
 {
-    SDL_SetRenderDrawColor(renderer, COLOR.r, COLOR.g, COLOR.b, COLOR.a);
+    SpriteCanvas canvas(RADIUS * 2 + 1, RADIUS * 2 + 1);
 
-    int xIncrement = X_INCREMENT[(size_t)facingDirection];
-    int yIncrement = Y_INCREMENT[(size_t)facingDirection];
-    for(int x = 0; x < RADIUS * 2; x++)
+    for(const Span& span : getWedgeSpans(RADIUS, facingDirection, mouthPixels))
     {
-        for(int y = 0; y < RADIUS * 2; y++)
+        for(int dx = span.dxStart; dx < span.dxStart + span.length; dx++)
         {
-            int dx = RADIUS - x;
-            int dy = RADIUS - y;
-            if(dx * dx + dy * dy <= RADIUS * RADIUS)
-            {
-                if(dy * yIncrement >= 0 && dx * xIncrement < mouthPixels && abs(dy) > abs(dx) && yIncrement != 0
-                   || dx * xIncrement >= 0 && dy * yIncrement < mouthPixels && abs(dx) > abs(dy) && xIncrement != 0)
-                {
-                    continue;
-                }
-                SDL_RenderDrawPoint(renderer, xCenter + dx, yCenter + dy);
-            }
+            canvas.setPixel(RADIUS + dx, RADIUS + span.dy, COLOR);
         }
     }
+
+    return canvas;
 }
 
 Pacman::Pacman(GameState& gameState) : Mover(gameState, PACMAN_START_ROW, PACMAN_START_COL, PACMAN_START_DIRECTION)
 {
     m_velocity = 300;
     m_name = "pacman";
+    m_spriteWidth = RADIUS * 2 + 1;
+    m_spriteHeight = RADIUS * 2 + 1;
 }
 
 void Pacman::update()
 {
     handleMovement();
 
-    int xCenter = X_CENTER(m_col) + m_xPixelOffset;
-    int yCenter = Y_CENTER(m_row) + m_yPixelOffset;
-    drawPacman(m_gameState.m_renderer, xCenter, yCenter, m_facingDirection, m_mouthPixels);
-
     if(abs(m_mouthPixels) >= RADIUS)
     {
         m_mouthIncrement *= -1;
@@ -198,6 +248,34 @@ void Pacman::update()
     m_mouthPixels += m_mouthIncrement;
 }
 
+void Pacman::fillSnapshot(SpriteSnapshot& sprite) const
+{
+    GridObject::fillSnapshot(sprite);
+    sprite.facingDirection = m_facingDirection;
+    sprite.frame = m_mouthPixels;
+}
+
+void Pacman::hashState(StateHash& hash) const
+{
+    Mover::hashState(hash);
+    hash.add(m_mouthPixels);
+    hash.add(m_mouthIncrement);
+}
+
+void Pacman::saveState(StateWriter& writer) const
+{
+    Mover::saveState(writer);
+    writer.write(m_mouthPixels);
+    writer.write(m_mouthIncrement);
+}
+
+void Pacman::restoreState(StateReader& reader)
+{
+    Mover::restoreState(reader);
+    reader.read(m_mouthPixels);
+    reader.read(m_mouthIncrement);
+}
+
 void Pacman::handleArrival()
 {
     m_gameState.handlePacmanArrival();
@@ -213,7 +291,7 @@ void Pacman::reset()
     m_row = PACMAN_START_ROW;
     m_col = PACMAN_START_COL;
     m_facingDirection = PACMAN_START_DIRECTION;
-    m_lastDrawnTicks = SDL_GetTicks64();
+    m_subPixels = 0;
 }
 
 std::vector<std::unique_ptr<Ghost>> Ghost::makeGhosts(GameState& gameState)
@@ -234,10 +312,13 @@ Ghost::Ghost(
     Direction startFacing,
     const SDL_Color& color,
     const std::string& name)
-: Mover(gameState, startRow, startCol, startFacing), m_color(color), m_index(nextIndex++)
+: Mover(gameState, startRow, startCol, startFacing), m_index(startCol - GHOST_START_COL), m_color(color),
+  m_timers(gameState.m_timerService, &gameState.m_gameTimers)
 {
     m_name = name;
     m_velocity = 100;
+    m_spriteWidth = SPRITE_WIDTH * SPRITE_SCALE;
+    m_spriteHeight = SPRITE_HEIGHT * SPRITE_SCALE;
 }
 
 void Ghost::update()
@@ -247,17 +328,82 @@ void Ghost::update()
     if(m_inBox && shouldLeaveBox())
     {
         relocate(GHOST_SPAWN_ROW, GHOST_SPAWN_COL);
+        m_corridor = MazeGraph::NONE;
         m_inBox = false;
     }
+}
 
-    SDL_Color color = m_color;
+void Ghost::fillSnapshot(SpriteSnapshot& sprite) const
+{
+    GridObject::fillSnapshot(sprite);
+    sprite.color = m_color;
     if(m_isFlashing)
     {
-        color = FLASH_COLOR[m_flashColorIndex];
+        sprite.color = FLASH_COLOR[m_flashColorIndex];
     }
+}
 
+void Ghost::hashState(StateHash& hash) const
+{
+    Mover::hashState(hash);
+    hash.add(m_inBox);
+    hash.add(m_isFlashing);
+    hash.add(m_flashColorIndex);
+    hash.add(m_chaseMode);
+    hash.add(m_chaseState);
+    hash.add(m_targetLocation.row);
+    hash.add(m_targetLocation.col);
+    hash.add(m_corridor);
+    hash.add(m_corridorStep);
+}
+
+void Ghost::saveState(StateWriter& writer) const
+{
+    Mover::saveState(writer);
+    writer.write(m_inBox);
+    writer.write(m_isFlashing);
+    writer.write(m_flashColorIndex);
+    writer.write(m_chaseMode);
+    writer.write(m_chaseState);
+    writer.write(m_targetLocation.row);
+    writer.write(m_targetLocation.col);
+    writer.write(m_corridor);
+    writer.write(m_corridorStep);
+
+    for(const TimerHandle* timer : {&m_chaseStateTimer, &m_flashingGhostTimer, &m_flashColorTimer})
+    {
+        timer->save(writer);
+    }
+}
+
+void Ghost::restoreState(StateReader& reader)
+{
+    Mover::restoreState(reader);
+    reader.read(m_inBox);
+    reader.read(m_isFlashing);
+    reader.read(m_flashColorIndex);
+    reader.read(m_chaseMode);
+    reader.read(m_chaseState);
+    reader.read(m_targetLocation.row);
+    reader.read(m_targetLocation.col);
+    reader.read(m_corridor);
+    reader.read(m_corridorStep);
+
+    auto& timerService = m_gameState.m_timerService;
+    const std::pair<TimerHandle*, TimerCallback> timers[] = {
+        {&m_chaseStateTimer, [this]() { advanceChaseState(); }},
+        {&m_flashingGhostTimer, [this]() { endFlashing(); }},
+        {&m_flashColorTimer, [this]() { m_flashColorIndex = 1 - m_flashColorIndex; }}};
+    for(const auto& [timer, callback] : timers)
+    {
+        timer->restore(reader, timerService, callback, &m_timers);
+    }
+}
+
+SpriteCanvas Ghost::rasterizeSprite()
+{
     // clang-format off
-    const std::vector<std::string> GHOST_GRID =
+    static const std::vector<std::string> GHOST_GRID =
     {
         "     xxxx     ",
         "   xxxxxxxx   ",
@@ -277,106 +423,130 @@ void Ghost::update()
     };
     // clang-format on
 
-    const int SCALING_FACTOR = 2;
-    std::vector<std::string> scaledGhost;
-
-    for(const auto& line : GHOST_GRID)
+    // the body is white so it can be tinted with the ghost or flash colour when drawn
+    SpriteCanvas canvas(SPRITE_WIDTH, SPRITE_HEIGHT);
+    for(int row = 0; row < (int)GHOST_GRID.size(); row++)
     {
-        std::string newString;
-        for(const auto& c : line)
+        for(int col = 0; col < (int)GHOST_GRID[row].length(); col++)
         {
-            for(int i = 0; i < SCALING_FACTOR; i++)
+            if(GHOST_GRID[row][col] == 'x')
             {
-                newString += c;
+                canvas.setPixel(col, row, COLOR_WHITE);
             }
         }
-
-        for(int i = 0; i < SCALING_FACTOR; i++)
-        {
-            scaledGhost.push_back(newString);
-        }
     }
 
-    SDL_SetRenderDrawColor(m_gameState.m_renderer, color.r, color.g, color.b, color.a);
-
-    for(int row = 0; row < scaledGhost.size(); row++)
-    {
-        for(int col = 0; col < scaledGhost[row].length(); col++)
-        {
-            if(scaledGhost[row][col] == 'x')
-            {
-                SDL_RenderDrawPoint(
-                    m_gameState.m_renderer,
-                    X_CENTER(m_col) + m_xPixelOffset + col - (int)scaledGhost[row].length() / 2,
-                    Y_CENTER(m_row) + m_yPixelOffset + row - (int)scaledGhost.size() / 2);
-            }
-        }
-    }
+    return canvas;
 }
 
 void Ghost::handleWall()
 {
     LOG_TRACE("%s hits wall", m_name.c_str());
     m_pendingDirection = (Direction)(((size_t)m_facingDirection + 1) % (size_t)Direction::MAX);
+    chooseCorridor();
 }
 
 void Ghost::handleArrival()
 {
-    for(size_t newDirIndex = 0; newDirIndex < (size_t)Direction::MAX; newDirIndex++)
+    const MazeGraph& maze = *m_gameState.m_maze;
+    if(m_corridor != MazeGraph::NONE)
     {
-        Direction newDirection = (Direction)newDirIndex;
-        if(directionValid(newDirection))
+        // on the corridor taken at the last junction every tile's way on is already known, nothing to look at until
+        // the junction at the end
+        const MazeGraph::Corridor& corridor = maze.getCorridor(m_corridor);
+        const MazeGraph::Step& step = maze.getStep(corridor, m_corridorStep++);
+        if(step.wraps)
         {
-            if(m_chaseMode == ChaseMode::SCATTER || directionIsCloser(newDirection, m_targetLocation))
-            {
-                m_pendingDirection = newDirection;
-                return;
-            }
+            relocate(m_row, m_gameState.m_board.getCols() - m_col - 1);
+        }
+        if(m_corridorStep < corridor.length)
+        {
+            m_pendingDirection = step.next;
+            return;
+        }
+    }
+    else
+    {
+        // put down partway along a corridor, by a reset or on leaving the box, so it's followed a tile at a time
+        const Bitboard& board = m_gameState.m_board;
+        if(board.isWrap(m_row, m_col))
+        {
+            relocate(m_row, board.getCols() - m_col - 1);
+        }
+        if(!maze.isJunction(m_row, m_col))
+        {
+            m_pendingDirection = maze.getWayOn(m_row, m_col, m_facingDirection);
+            return;
         }
     }
+
+    // pacman keeps moving, so the chase target is picked again at every junction
+    if(m_chaseMode == ChaseMode::CHASE)
+    {
+        calculateTargetLocation();
+    }
+
+    // nothing to do on the target itself or in the box, which is walled off from the maze, the ghost carries on
+    const std::optional<Direction> direction =
+        m_gameState.m_navigation->getNextDirection(getPosition(), m_targetLocation);
+    if(direction.has_value())
+    {
+        m_pendingDirection = *direction;
+    }
+    chooseCorridor();
+}
+
+void Ghost::chooseCorridor()
+{
+    // Whichever way the ghost is about to take, if it's at a junction. Nothing if it's a wall, the ghost then hits it
+    // and tries another way.
+    const MazeGraph& maze = *m_gameState.m_maze;
+    const int junction = maze.getJunction(m_row, m_col);
+    m_corridor = junction == MazeGraph::NONE ? MazeGraph::NONE : maze.findCorridor(junction, m_pendingDirection);
+    m_corridorStep = 0;
 }
 
 void Ghost::reset()
 {
     relocate(GHOST_START_ROW, GHOST_START_COL + m_index);
+    m_corridor = MazeGraph::NONE;
     m_inBox = true;
     m_isFlashing = false;
+    m_timers.stopAll();
     resetChaseState();
 }
 
 void Ghost::handleSuperDot()
 {
-    auto& timerService = TimerService::getInstance();
+    auto& timerService = m_gameState.m_timerService;
 
-    timerService.pauseTimer(m_chaseStateTimerKey);
-
-    size_t flashColorTimerKey =
-        timerService.addTimer(1000, true, [this]() { m_flashColorIndex = 1 - m_flashColorIndex; });
-    timerService.startTimer(flashColorTimerKey);
+    m_chaseStateTimer.pause();
 
+    // while already flashing the same timers just start over
     if(!m_isFlashing)
     {
-        // only add new timer if it doesn't already exist
-        m_flashingGhostTimerKey = timerService.addTimer(
-            m_gameState.m_flashingGhostDurationMs,
-            false,
-            [this, flashColorTimerKey]()
-            {
-                auto& timerService = TimerService::getInstance();
-                timerService.stopTimer(flashColorTimerKey);
-
-                m_gameState.m_flashingGhostPoints = m_gameState.DEFAULT_FLASHING_GHOST_POINTS;
-                m_isFlashing = false;
-                m_chaseMode = m_chaseSettings[(size_t)m_chaseState].chaseMode;
-                timerService.startTimer(m_chaseStateTimerKey);
-            });
+        m_flashColorTimer =
+            timerService.addTimer(1000, true, [this]() { m_flashColorIndex = 1 - m_flashColorIndex; }, &m_timers);
+        m_flashColorTimer.start();
+        m_flashingGhostTimer = timerService.addTimer(
+            m_gameState.m_flashingGhostDurationMs, false, [this]() { endFlashing(); }, &m_timers);
     }
 
-    timerService.startTimer(m_flashingGhostTimerKey);
-    m_chaseMode = ChaseMode::FRIGHTENED;
+    m_flashingGhostTimer.start();
+    setChaseMode(ChaseMode::FRIGHTENED);
     m_isFlashing = true;
 }
 
+void Ghost::endFlashing()
+{
+    m_flashColorTimer.stop();
+
+    m_gameState.m_flashingGhostPoints = m_gameState.DEFAULT_FLASHING_GHOST_POINTS;
+    m_isFlashing = false;
+    setChaseMode(m_chaseSettings[(size_t)m_chaseState].chaseMode);
+    m_chaseStateTimer.start();
+}
+
 void Ghost::setChaseMode(const ChaseMode chaseMode)
 {
     m_chaseMode = chaseMode;
@@ -386,9 +556,8 @@ void Ghost::setChaseMode(const ChaseMode chaseMode)
         calculateTargetLocation();
         break;
     case ChaseMode::FRIGHTENED:
-        m_targetLocation = m_defaultTargetLocation;
-        break;
     case ChaseMode::SCATTER:
+        m_targetLocation = m_defaultTargetLocation;
         break;
     default:
         break;
@@ -397,7 +566,7 @@ void Ghost::setChaseMode(const ChaseMode chaseMode)
 
 void Ghost::resetChaseState()
 {
-    TimerService::getInstance().stopTimer(m_chaseStateTimerKey);
+    m_chaseStateTimer.stop();
     m_chaseState = ChaseState::INITIAL_STATE;
     advanceChaseState();
 }
@@ -416,10 +585,10 @@ void Ghost::advanceChaseState()
     setChaseMode(m_chaseSettings[chaseStateIndex].chaseMode);
 
     // set timer for next state change
-    auto& timerService = TimerService::getInstance();
-    m_chaseStateTimerKey =
-        timerService.addTimer(m_chaseSettings[chaseStateIndex].durationMs, false, [this]() { advanceChaseState(); });
-    timerService.startTimer(m_chaseStateTimerKey);
+    // replacing the handle stops the timer that just expired, if that's what called this
+    m_chaseStateTimer = m_gameState.m_timerService.addTimer(
+        m_chaseSettings[chaseStateIndex].durationMs, false, [this]() { advanceChaseState(); }, &m_timers);
+    m_chaseStateTimer.start();
 }
 
 void Blinky::calculateTargetLocation()
@@ -475,7 +644,7 @@ void Clyde::calculateTargetLocation()
 
 bool Clyde::shouldLeaveBox()
 {
-    return m_gameState.m_dotsEaten >= 2 * m_gameState.m_dotsRemaining;
+    return m_gameState.m_dotsEaten >= 2 * m_gameState.m_board.getDotCount();
 }
 
 static const std::string FRUIT_SPRITES =
@@ -624,42 +793,65 @@ DisplayFruit::DisplayFruit(GameState& gameState, int index)
 {
     m_name = std::string("fruit ") + std::to_string(index);
     m_xPixelOffset = -2 * index;
+    m_spriteWidth = FRUIT_WIDTH * SPRITE_SCALE;
+    m_spriteHeight = FRUIT_HEIGHT * SPRITE_SCALE;
+    savePreviousPosition();
 }
 
-void DisplayFruit::update()
+void DisplayFruit::fillSnapshot(SpriteSnapshot& sprite) const
 {
-    static const int SCALING_FACTOR = 2;
+    GridObject::fillSnapshot(sprite);
+    sprite.frame = m_index;
+}
 
-    int spriteIndex = m_index * FRUIT_WIDTH * FRUIT_HEIGHT;
-    for(int rowOffset = 0; rowOffset < FRUIT_HEIGHT * SCALING_FACTOR; rowOffset += SCALING_FACTOR)
+void DisplayFruit::hashState(StateHash& hash) const
+{
+    GridObject::hashState(hash);
+    hash.add(m_index);
+}
+
+void DisplayFruit::saveState(StateWriter& writer) const
+{
+    GridObject::saveState(writer);
+    writer.write(m_index);
+}
+
+void DisplayFruit::restoreState(StateReader& reader)
+{
+    GridObject::restoreState(reader);
+    reader.read(m_index);
+}
+
+int DisplayFruit::getNumSprites()
+{
+    return MAX_FRUIT;
+}
+
+SpriteCanvas DisplayFruit::rasterizeSprite(const int index)
+{
+    SpriteCanvas canvas(FRUIT_WIDTH, FRUIT_HEIGHT);
+
+    int spriteIndex = index * FRUIT_WIDTH * FRUIT_HEIGHT;
+    for(int row = 0; row < FRUIT_HEIGHT; row++)
     {
-        for(int colOffset = 0; colOffset < FRUIT_WIDTH * SCALING_FACTOR; colOffset += SCALING_FACTOR)
+        for(int col = 0; col < FRUIT_WIDTH; col++)
         {
-            for(int rowScale = 0; rowScale < SCALING_FACTOR; rowScale++)
-                for(int colScale = 0; colScale < SCALING_FACTOR; colScale++)
-                {
-                    if(FRUIT_SPRITES[spriteIndex] == ' ')
-                    {
-                        goto nextPixel;
-                    }
-                    SDL_Color color = COLOR_MAP.at(FRUIT_SPRITES[spriteIndex]);
-                    SDL_SetRenderDrawColor(m_gameState.m_renderer, color.r, color.g, color.b, color.a);
-                    SDL_RenderDrawPoint(
-                        m_gameState.m_renderer,
-                        X_CENTER(m_col) + m_xPixelOffset + colOffset + colScale - FRUIT_WIDTH,
-                        Y_CENTER(m_row) + m_yPixelOffset + rowOffset + rowScale - FRUIT_HEIGHT);
-                }
-
-nextPixel:
+            if(FRUIT_SPRITES[spriteIndex] != ' ')
+            {
+                canvas.setPixel(col, row, COLOR_MAP.at(FRUIT_SPRITES[spriteIndex]));
+            }
             ++spriteIndex;
         }
     }
+
+    return canvas;
 }
 
 PointsFruit::PointsFruit(GameState& gameState) : DisplayFruit(gameState, -1)
 {
     m_row = FRUIT_SPAWN_ROW;
     m_col = FRUIT_SPAWN_COL;
+    savePreviousPosition();
 }
 
 void PointsFruit::update()
@@ -669,22 +861,42 @@ void PointsFruit::update()
         m_index = m_gameState.m_level - 1;
         if(m_index >= MAX_FRUIT)
         {
-            m_index = MAX_FRUIT;
+            m_index = MAX_FRUIT - 1;
         }
-        DisplayFruit::update();
     }
 }
 
 void PointsFruit::reset()
 {
     m_available = false;
-    TimerService::getInstance().stopTimer(m_availabilityTimerKey);
+    m_availabilityTimer.stop();
+}
+
+void PointsFruit::hashState(StateHash& hash) const
+{
+    DisplayFruit::hashState(hash);
+    hash.add(m_available);
+}
+
+void PointsFruit::saveState(StateWriter& writer) const
+{
+    DisplayFruit::saveState(writer);
+    writer.write(m_available);
+    m_availabilityTimer.save(writer);
+}
+
+void PointsFruit::restoreState(StateReader& reader)
+{
+    DisplayFruit::restoreState(reader);
+    reader.read(m_available);
+    m_availabilityTimer.restore(
+        reader, m_gameState.m_timerService, [this]() { m_available = false; }, &m_gameState.m_levelTimers);
 }
 
 void PointsFruit::activate()
 {
     m_available = true;
-    auto& timerService = TimerService::getInstance();
-    m_availabilityTimerKey = timerService.addTimer(FRUIT_DURATION_TICKS, false, [this]() { m_available = false; });
-    timerService.startTimer(m_availabilityTimerKey);
+    m_availabilityTimer = m_gameState.m_timerService.addTimer(
+        FRUIT_DURATION_TICKS, false, [this]() { m_available = false; }, &m_gameState.m_levelTimers);
+    m_availabilityTimer.start();
 }
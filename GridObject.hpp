@@ -3,17 +3,17 @@
 #include <memory>
 #include <SDL.h>
 
+#include "FrameSnapshot.hpp"
+#include "MazeGraph.hpp"
+#include "SpriteAtlas.hpp"
+#include "StateHash.hpp"
+#include "StateSerializer.hpp"
+#include "TimerService.hpp"
 #include "util.hpp"
 
 // forward declaration
 class GameState;
 
-struct GridPosition
-{
-    int row;
-    int col;
-};
-
 class GridObject
 {
 public:
@@ -23,18 +23,27 @@ public:
     GridObject(GameState& gameState, int row, int col);
     virtual void update() = 0;
     virtual void reset() = 0;
+    virtual void fillSnapshot(SpriteSnapshot& sprite) const;
+    virtual void hashState(StateHash& hash) const;
+    virtual void saveState(StateWriter& writer) const;
+    virtual void restoreState(StateReader& reader);
     GridPosition getPosition() const
     {
         return {m_row, m_col};
     }
     bool hasSamePositionAs(const GridObject& otherObject) const;
     void relocate(int row, int col);
+    SDL_Point getPixelCenter() const;
+    void savePreviousPosition();
 
 protected:
     int m_row;
     int m_col;
     int m_xPixelOffset = 0; // offset from center within the column
     int m_yPixelOffset = 0; // offset from center within the row
+    int m_spriteWidth = 0;
+    int m_spriteHeight = 0;
+    SDL_Point m_previousCenter; // pixel center as of the previous tick
     std::string m_name;
     GameState& m_gameState;
 };
@@ -51,18 +60,20 @@ public:
     {
         return m_facingDirection;
     }
+    void hashState(StateHash& hash) const override;
+    void saveState(StateWriter& writer) const override;
+    void restoreState(StateReader& reader) override;
 
 protected:
     virtual void handleArrival() {};
     virtual void handleWall() = 0;
     virtual void handleMovement();
     bool directionValid(const Direction newDirection) const;
-    bool directionIsCloser(const Direction newDirection, const GridPosition& otherPosition) const;
 
 protected:
     Direction m_facingDirection = Direction::LEFT;
     Direction m_pendingDirection = Direction::LEFT;
-    uint64_t m_lastDrawnTicks = 0;
+    int m_subPixels = 0;  // movement carried over between ticks, in 1 / GameState::TICKS_PER_SECOND pixels
     int m_velocity = 100; // pixels per second (might need to change based on resizable window)
 };
 
@@ -70,12 +81,7 @@ class Pacman : public Mover
 {
 public:
     static inline const int RADIUS = 14;
-    static void drawPacman(
-        SDL_Renderer* renderer,
-        const int xCenter,
-        const int yCenter,
-        const Direction facingDirection,
-        const int mouthPixels);
+    static SpriteCanvas rasterizeSprite(const Direction facingDirection, const int mouthPixels);
 
     Pacman() = delete;
     Pacman(Pacman&) = delete;
@@ -83,6 +89,10 @@ public:
     Pacman(GameState& gameState);
     void update() override;
     void reset() override;
+    void fillSnapshot(SpriteSnapshot& sprite) const override;
+    void hashState(StateHash& hash) const override;
+    void saveState(StateWriter& writer) const override;
+    void restoreState(StateReader& reader) override;
 
 protected:
     void handleArrival() override;
@@ -101,7 +111,11 @@ private:
 class Ghost : public Mover
 {
 public:
+    static inline const int SPRITE_WIDTH = 14;
+    static inline const int SPRITE_HEIGHT = 15;
+    static inline const int SPRITE_SCALE = 2;
     static std::vector<std::unique_ptr<Ghost>> makeGhosts(GameState& gameState);
+    static SpriteCanvas rasterizeSprite();
 
     enum class ChaseMode
     {
@@ -122,6 +136,10 @@ public:
         const std::string& name);
     void update() override;
     void reset() override;
+    void fillSnapshot(SpriteSnapshot& sprite) const override;
+    void hashState(StateHash& hash) const override;
+    void saveState(StateWriter& writer) const override;
+    void restoreState(StateReader& reader) override;
     void handleSuperDot();
     void resetChaseState();
 
@@ -133,7 +151,9 @@ protected:
 
 private:
     void setChaseMode(const ChaseMode chaseMode);
+    void chooseCorridor();
     void advanceChaseState();
+    void endFlashing();
 
 public:
     bool m_inBox = true;
@@ -145,7 +165,7 @@ protected:
     static inline const Direction GHOST_START_DIRECTION = Direction::LEFT;
 
     ChaseMode m_chaseMode = ChaseMode::SCATTER;
-    GridPosition m_targetLocation;
+    GridPosition m_targetLocation = {0, 0};
     GridPosition m_defaultTargetLocation;
 
 private:
@@ -154,12 +174,17 @@ private:
     static inline const int GHOST_SPAWN_COL = 15;
     static inline const SDL_Color FLASH_COLOR[2] = {COLOR_WHITE, COLOR_BLUE};
 
-    static inline int nextIndex = 0;
-    const int m_index;
+    const int m_index; // position in the box, from the starting column
 
     SDL_Color m_color;
     int m_flashColorIndex = 0;
-    size_t m_flashingGhostTimerKey;
+
+    // the corridor taken at the last junction and how many of its tiles have been reached, NONE away from the maze
+    int m_corridor = MazeGraph::NONE;
+    int m_corridorStep = 0;
+    TimerGroup m_timers; // everything below, stopped when the ghost is reset
+    TimerHandle m_flashingGhostTimer;
+    TimerHandle m_flashColorTimer;
 
     enum class ChaseState
     {
@@ -191,7 +216,7 @@ private:
          {Ghost::ChaseMode::SCATTER, 5000},
          {Ghost::ChaseMode::CHASE, 0}}};
 
-    size_t m_chaseStateTimerKey;
+    TimerHandle m_chaseStateTimer;
     ChaseState m_chaseState = ChaseState::INITIAL_STATE;
 };
 
@@ -254,14 +279,21 @@ private:
 class DisplayFruit : public GridObject
 {
 public:
+    static inline const int SPRITE_SCALE = 2;
     static std::vector<DisplayFruit> makeDisplayFruits(GameState& gameState);
+    static int getNumSprites();
+    static SpriteCanvas rasterizeSprite(const int index);
 
     DisplayFruit(GameState& gameState, int index);
     DisplayFruit() = delete;
     DisplayFruit(DisplayFruit&) = delete;
     DisplayFruit(DisplayFruit&&) = default;
-    virtual void update() override;
+    virtual void update() override {};
     virtual void reset() override {};
+    virtual void fillSnapshot(SpriteSnapshot& sprite) const override;
+    virtual void hashState(StateHash& hash) const override;
+    virtual void saveState(StateWriter& writer) const override;
+    virtual void restoreState(StateReader& reader) override;
 
 protected:
     int m_index;
@@ -280,8 +312,11 @@ public:
     PointsFruit(GameState& gameState);
     virtual void update() override;
     void reset() override;
+    void hashState(StateHash& hash) const override;
+    void saveState(StateWriter& writer) const override;
+    void restoreState(StateReader& reader) override;
     void activate();
-    inline bool isActive()
+    inline bool isActive() const
     {
         return m_available;
     }
@@ -292,5 +327,5 @@ private:
     static inline const int FRUIT_DURATION_TICKS = 8000;
 
     bool m_available = false;
-    size_t m_availabilityTimerKey;
+    TimerHandle m_availabilityTimer;
 };
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "InputScript.hpp"
+#include "util.hpp"
+
+static bool parseDirection(const std::string& name, Direction& direction)
+{
+    for(size_t index = 0; index < (size_t)Direction::MAX; index++)
+    {
+        if(name == DIRECTION_AS_STRING[index])
+        {
+            direction = (Direction)index;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool loadInputScript(const char* path, std::vector<ScriptedInput>& script)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to open input script %s", path);
+        return false;
+    }
+
+    std::string line;
+    for(int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        std::istringstream fields(line);
+        std::string first;
+        if(!(fields >> first) || first[0] == '#')
+        {
+            continue;
+        }
+
+        ScriptedInput scripted;
+        std::string directionName;
+        std::string action;
+        char* end = nullptr;
+        scripted.tick = strtoull(first.c_str(), &end, 10);
+        if(*end != '\0' || !(fields >> directionName >> action)
+           || !parseDirection(directionName, scripted.input.direction) || (action != "press" && action != "release"))
+        {
+            LOG_ERROR("%s:%d: expected \"<tick> <direction> <press|release>\"", path, lineNumber);
+            return false;
+        }
+        scripted.input.pressed = action == "press";
+        script.push_back(scripted);
+    }
+
+    // the file doesn't have to be in order, but events for the same tick keep theirs
+    std::stable_sort(
+        script.begin(),
+        script.end(),
+        [](const ScriptedInput& a, const ScriptedInput& b) { return a.tick < b.tick; });
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "GameState.hpp"
+
+// Scripted input for runs without a player, one event per line:
+//     <tick> <UP|DOWN|LEFT|RIGHT> <press|release>
+// Events are applied before the given tick (counting from 0) runs. Blank lines and lines starting with # are ignored.
+
+struct ScriptedInput
+{
+    uint64_t tick;
+    InputEvent input;
+};
+
+// the events come back sorted by tick, events for the same tick keep the order they were written in
+bool loadInputScript(const char* path, std::vector<ScriptedInput>& script);
@@ -0,0 +1,528 @@
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const char* const LEVEL_NAMES[] = {
+        "LOG_LEVEL_OFF",
+        "LOG_LEVEL_ASSERT",
+        "LOG_LEVEL_ERROR",
+        "LOG_LEVEL_WARN",
+        "LOG_LEVEL_INFO",
+        "LOG_LEVEL_DEBUG",
+        "LOG_LEVEL_TRACE"};
+    const char* const LEVEL_SPEC_NAMES[] = {"off", "assert", "error", "warn", "info", "debug", "trace"};
+
+    // Bounded multi-producer queue. A slot's sequence says whose turn it is: free for position p while it holds p,
+    // ready to read once the producer sets it to p + 1, and free again for p + RING_SIZE once read. Sequences are
+    // stored less the slot's index so the zero initialized ring starts out all free, whatever runs first.
+    const uint64_t RING_SIZE = 1024;
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    std::array<Slot, RING_SIZE> ring;
+    std::atomic<uint64_t> enqueuePosition {0};
+    std::atomic<uint64_t> dequeuePosition {0};
+    std::atomic<uint64_t> writtenPosition {0}; // everything before this has reached stdout
+    std::atomic<uint64_t> droppedCount {0};
+    std::atomic<bool> writerStopped {false};
+
+    // the position claimed by this thread's beginRecord, or the scratch record when writing straight away
+    thread_local uint64_t claimedPosition = 0;
+    thread_local LogRecord scratchRecord;
+
+    uint64_t getSequence(uint64_t position)
+    {
+        return ring[position % RING_SIZE].sequence.load(std::memory_order_acquire) + position % RING_SIZE;
+    }
+
+    void setSequence(uint64_t position, uint64_t sequence)
+    {
+        ring[position % RING_SIZE].sequence.store(sequence - position % RING_SIZE, std::memory_order_release);
+    }
+
+    template<typename T>
+    void appendFormatted(std::string& out, const char* spec, T value)
+    {
+        char buffer[256];
+        const int length = snprintf(buffer, sizeof(buffer), spec, value);
+        if(length < 0)
+        {
+            return;
+        }
+        if((size_t)length < sizeof(buffer))
+        {
+            out.append(buffer, length);
+            return;
+        }
+        const size_t start = out.size();
+        out.resize(start + length + 1);
+        snprintf(&out[start], length + 1, spec, value);
+        out.resize(start + length);
+    }
+
+    class ArgReader
+    {
+    public:
+        ArgReader(const LogRecord& record) : m_next(record.payload), m_end(record.payload + record.size) {}
+
+        bool done() const
+        {
+            return m_next >= m_end;
+        }
+
+        // formats the next argument with a single conversion spec, as printf would have
+        void format(std::string& out, const char* spec)
+        {
+            switch((LogRecord::ArgType)*m_next++)
+            {
+            case LogRecord::ArgType::INT32:
+                appendFormatted(out, spec, read<int32_t>());
+                break;
+            case LogRecord::ArgType::UINT32:
+                appendFormatted(out, spec, read<uint32_t>());
+                break;
+            case LogRecord::ArgType::INT64:
+                appendFormatted(out, spec, read<int64_t>());
+                break;
+            case LogRecord::ArgType::UINT64:
+                appendFormatted(out, spec, read<uint64_t>());
+                break;
+            case LogRecord::ArgType::DOUBLE:
+                appendFormatted(out, spec, read<double>());
+                break;
+            case LogRecord::ArgType::STRING:
+            {
+                const uint16_t length = read<uint16_t>();
+                appendFormatted(out, spec, (const char*)m_next);
+                m_next += length + 1;
+                break;
+            }
+            case LogRecord::ArgType::POINTER:
+                appendFormatted(out, spec, read<const void*>());
+                break;
+            }
+        }
+
+        // for a * width or precision
+        int readInt()
+        {
+            if(done() || (LogRecord::ArgType)*m_next != LogRecord::ArgType::INT32)
+            {
+                return 0;
+            }
+            m_next++;
+            return read<int32_t>();
+        }
+
+    private:
+        template<typename T>
+        T read()
+        {
+            T value;
+            memcpy(&value, m_next, sizeof(T));
+            m_next += sizeof(T);
+            return value;
+        }
+
+        const uint8_t* m_next;
+        const uint8_t* m_end;
+    };
+
+    void formatRecord(const LogRecord& record, std::string& out)
+    {
+        appendFormatted(out, "[%s] ", LEVEL_NAMES[record.level]);
+        appendFormatted(out, "%s:", record.file);
+        appendFormatted(out, "%d: ", record.line);
+
+        ArgReader args(record);
+        const char* next = record.format;
+        while(*next != '\0')
+        {
+            const char* percent = strchr(next, '%');
+            if(percent == nullptr)
+            {
+                out += next;
+                break;
+            }
+            out.append(next, percent - next);
+            if(percent[1] == '%')
+            {
+                out += '%';
+                next = percent + 2;
+                continue;
+            }
+
+            // copy out one conversion spec, filling in any * from the arguments
+            char spec[32] = "%";
+            size_t specLength = 1;
+            const char* conversion = percent + 1;
+            while(*conversion != '\0' && strchr("-+ #0123456789.*hljztL", *conversion) != nullptr)
+            {
+                if(*conversion == '*')
+                {
+                    specLength += snprintf(spec + specLength, sizeof(spec) - specLength, "%d", args.readInt());
+                }
+                else if(specLength + 2 < sizeof(spec))
+                {
+                    spec[specLength++] = *conversion;
+                }
+                conversion++;
+            }
+            if(*conversion == '\0')
+            {
+                out += percent;
+                break;
+            }
+            spec[specLength++] = *conversion;
+            spec[specLength] = '\0';
+            next = conversion + 1;
+
+            if(*conversion != 'n' && !args.done())
+            {
+                args.format(out, spec);
+            }
+        }
+
+        if(record.truncated)
+        {
+            out += " [arguments truncated]";
+        }
+        out += '\n';
+    }
+
+    void writeOut(const std::string& text)
+    {
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+    }
+
+    // Started by the first message queued. Sleeps until woken by a new message, with a timeout in case the wake up
+    // raced with it going to sleep, since producers never take the mutex.
+    class LogWriter
+    {
+    public:
+        LogWriter() : m_thread(&LogWriter::run, this) {}
+        ~LogWriter()
+        {
+            m_stopping = true;
+            wake();
+            m_thread.join();
+            writerStopped.store(true, std::memory_order_release);
+        }
+
+        void wake()
+        {
+            m_wake.notify_one();
+        }
+
+    private:
+        static inline const auto IDLE_TIMEOUT = std::chrono::milliseconds(20);
+        static inline const size_t MAX_BATCH_BYTES = 16 * 1024;
+
+        void run()
+        {
+            std::string batch;
+            while(true)
+            {
+                const uint64_t position = dequeuePosition.load(std::memory_order_relaxed);
+                if(getSequence(position) == position + 1)
+                {
+                    formatRecord(ring[position % RING_SIZE].record, batch);
+                    setSequence(position, position + RING_SIZE);
+                    dequeuePosition.store(position + 1, std::memory_order_release);
+                    if(batch.size() < MAX_BATCH_BYTES)
+                    {
+                        continue;
+                    }
+                }
+
+                if(const uint64_t dropped = droppedCount.exchange(0))
+                {
+                    appendFormatted(
+                        batch,
+                        "[LOG_LEVEL_WARN] Logger.cpp: log queue was full, dropped %llu messages\n",
+                        (unsigned long long)dropped);
+                }
+                if(!batch.empty())
+                {
+                    writeOut(batch);
+                    batch.clear();
+                }
+                writtenPosition.store(dequeuePosition.load(std::memory_order_relaxed), std::memory_order_release);
+
+                const uint64_t nextPosition = dequeuePosition.load(std::memory_order_relaxed);
+                if(getSequence(nextPosition) != nextPosition + 1)
+                {
+                    if(m_stopping && enqueuePosition.load() == nextPosition)
+                    {
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait_for(lock, IDLE_TIMEOUT);
+                }
+            }
+        }
+
+        std::atomic<bool> m_stopping {false};
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+    };
+
+    LogWriter& getWriter()
+    {
+        static LogWriter writer;
+        return writer;
+    }
+
+    // registration only happens once per call site, so the lock is off the hot path
+    struct ModuleRegistry
+    {
+        std::mutex mutex;
+        std::array<std::string, Logger::MAX_MODULES> names;
+        int count = 1; // 0 is shared by everything registered once the table is full
+        int defaultLevel = LOG_LEVEL_INFO;
+        std::vector<std::pair<std::string, int>> overrides;
+
+        int getLevel(const std::string& name) const
+        {
+            for(const auto& [module, level] : overrides)
+            {
+                if(module == name)
+                {
+                    return level;
+                }
+            }
+            return defaultLevel;
+        }
+    };
+
+    ModuleRegistry& getRegistry()
+    {
+        static ModuleRegistry registry;
+        return registry;
+    }
+
+    std::string getModuleName(const char* file)
+    {
+        const char* start = file;
+        for(const char* next = file; *next != '\0'; next++)
+        {
+            if(*next == '/' || *next == '\\')
+            {
+                start = next + 1;
+            }
+        }
+        const char* end = strrchr(start, '.');
+        return end != nullptr ? std::string(start, end) : std::string(start);
+    }
+
+    int parseLevel(const std::string& name)
+    {
+        for(int level = LOG_LEVEL_OFF; level <= LOG_LEVEL_TRACE; level++)
+        {
+            if(name == LEVEL_SPEC_NAMES[level])
+            {
+                return level;
+            }
+        }
+        return -1;
+    }
+}
+
+void LogRecord::add(const char* text)
+{
+    if(text == nullptr)
+    {
+        text = "(null)";
+    }
+    if(size + 1 + sizeof(uint16_t) + 1 > PAYLOAD_SIZE)
+    {
+        truncated = true;
+        return;
+    }
+    const size_t room = PAYLOAD_SIZE - size - 1 - sizeof(uint16_t) - 1;
+    const uint16_t length = (uint16_t)std::min(strlen(text), room);
+    truncated |= text[length] != '\0';
+    payload[size++] = (uint8_t)ArgType::STRING;
+    memcpy(payload + size, &length, sizeof(length));
+    size += sizeof(length);
+    memcpy(payload + size, text, length);
+    size += length;
+    payload[size++] = '\0';
+}
+
+int Logger::registerModule(const char* file)
+{
+    const std::string name = getModuleName(file);
+    ModuleRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for(int module = 1; module < registry.count; module++)
+    {
+        if(registry.names[module] == name)
+        {
+            return module;
+        }
+    }
+
+    int module = 0;
+    if(registry.count < MAX_MODULES)
+    {
+        module = registry.count++;
+        registry.names[module] = name;
+    }
+    moduleLevels[module].store(module == 0 ? registry.defaultLevel : registry.getLevel(name));
+    return module;
+}
+
+bool Logger::configure(const char* spec)
+{
+    // parsed in full before anything changes, so a typo doesn't leave half of it applied
+    int defaultLevel = -1;
+    std::vector<std::pair<std::string, int>> overrides;
+    const std::string text = spec;
+    size_t start = 0;
+    while(start <= text.size())
+    {
+        const size_t end = std::min(text.find(',', start), text.size());
+        const std::string item = text.substr(start, end - start);
+        start = end + 1;
+        if(item.empty())
+        {
+            continue;
+        }
+
+        const size_t equals = item.find('=');
+        const int level = parseLevel(equals == std::string::npos ? item : item.substr(equals + 1));
+        if(level < 0)
+        {
+            LOG_ERROR("Unknown log level in %s", item.c_str());
+            return false;
+        }
+        if(equals == std::string::npos)
+        {
+            defaultLevel = level;
+        }
+        else
+        {
+            overrides.emplace_back(item.substr(0, equals), level);
+        }
+    }
+
+    ModuleRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if(defaultLevel >= 0)
+    {
+        registry.defaultLevel = defaultLevel;
+    }
+    for(auto& [module, level] : overrides)
+    {
+        const auto existing = std::find_if(
+            registry.overrides.begin(),
+            registry.overrides.end(),
+            [&](const auto& entry) { return entry.first == module; });
+        if(existing != registry.overrides.end())
+        {
+            existing->second = level;
+        }
+        else
+        {
+            registry.overrides.emplace_back(std::move(module), level);
+        }
+    }
+
+    moduleLevels[0].store(registry.defaultLevel);
+    for(int module = 1; module < registry.count; module++)
+    {
+        moduleLevels[module].store(registry.getLevel(registry.names[module]));
+    }
+    return true;
+}
+
+void Logger::flush()
+{
+    if(writerStopped.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    const uint64_t target = enqueuePosition.load();
+    while(writtenPosition.load(std::memory_order_acquire) < target)
+    {
+        getWriter().wake();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+LogRecord* Logger::beginRecord(int level, const char* file, int line, const char* format)
+{
+    LogRecord* record = &scratchRecord;
+    if(level > LOG_LEVEL_ASSERT && !writerStopped.load(std::memory_order_acquire))
+    {
+        getWriter();
+
+        // claim the next free slot, giving up if the reader hasn't freed it yet
+        uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while(true)
+        {
+            const uint64_t sequence = getSequence(position);
+            if(sequence == position)
+            {
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(sequence < position)
+            {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        claimedPosition = position;
+        record = &ring[position % RING_SIZE].record;
+    }
+    else
+    {
+        // asserts exit straight after, so they can't wait for the writer, but what came before goes out first
+        flush();
+    }
+
+    record->format = format;
+    record->file = file;
+    record->line = line;
+    record->level = std::clamp(level, LOG_LEVEL_OFF, LOG_LEVEL_TRACE);
+    record->size = 0;
+    record->truncated = false;
+    return record;
+}
+
+void Logger::endRecord(LogRecord* record)
+{
+    if(record == &scratchRecord)
+    {
+        std::string text;
+        formatRecord(*record, text);
+        writeOut(text);
+        return;
+    }
+
+    setSequence(claimedPosition, claimedPosition + 1);
+    getWriter().wake();
+}
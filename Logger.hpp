@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+#define LOG_LEVEL_TRACE (6)
+#define LOG_LEVEL_DEBUG (5)
+#define LOG_LEVEL_INFO (4)
+#define LOG_LEVEL_WARN (3)
+#define LOG_LEVEL_ERROR (2)
+#define LOG_LEVEL_ASSERT (1)
+#define LOG_LEVEL_OFF (0)
+
+// Each source file is a module with its own level, INFO unless changed with Logger::configure. The check is a static
+// and an atomic load, so disabled messages cost next to nothing. The if(false) printf is never run, it only keeps the
+// compiler checking the arguments against the format.
+
+// GNU C++ doesn't handle empty __VA_ARGS__ the same as MSVC
+#ifdef __GNUG__
+#define LOG_AT_LEVEL(level, format, ...)                                     \
+    do                                                                       \
+    {                                                                        \
+        static const int logModule = Logger::registerModule(__FILE__);       \
+        if(Logger::isEnabled(logModule, level))                              \
+        {                                                                    \
+            Logger::write(level, __FILE__, __LINE__, format, ##__VA_ARGS__); \
+        }                                                                    \
+        if(false)                                                            \
+        {                                                                    \
+            printf(format, ##__VA_ARGS__);                                   \
+        }                                                                    \
+    } while(false)
+#define LOG_TRACE(format, ...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_AT_LEVEL(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_AT_LEVEL(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define LOG_ASSERT(condition, format, ...)                                           \
+    if(!(condition))                                                                 \
+    {                                                                                \
+        LOG_AT_LEVEL(LOG_LEVEL_ASSERT, #condition " fails, " format, ##__VA_ARGS__); \
+        exit(EXIT_FAILURE);                                                          \
+    }
+#else
+#define LOG_AT_LEVEL(level, format, ...)                                   \
+    do                                                                     \
+    {                                                                      \
+        static const int logModule = Logger::registerModule(__FILE__);     \
+        if(Logger::isEnabled(logModule, level))                            \
+        {                                                                  \
+            Logger::write(level, __FILE__, __LINE__, format, __VA_ARGS__); \
+        }                                                                  \
+        if(false)                                                          \
+        {                                                                  \
+            printf(format, __VA_ARGS__);                                   \
+        }                                                                  \
+    } while(false)
+#define LOG_TRACE(format, ...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, format, __VA_ARGS__)
+#define LOG_DEBUG(format, ...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, format, __VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_AT_LEVEL(LOG_LEVEL_INFO, format, __VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_AT_LEVEL(LOG_LEVEL_WARN, format, __VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, format, __VA_ARGS__)
+#define LOG_ASSERT(condition, format, ...)                                         \
+    if(!(condition))                                                               \
+    {                                                                              \
+        LOG_AT_LEVEL(LOG_LEVEL_ASSERT, #condition " fails, " format, __VA_ARGS__); \
+        exit(EXIT_FAILURE);                                                        \
+    }
+#endif
+
+// One message as the logging thread hands it over: the format string and file by pointer, the arguments as tagged
+// binary values. Strings are copied, since they often don't outlive the call.
+struct LogRecord
+{
+    static inline const size_t PAYLOAD_SIZE = 224;
+
+    enum class ArgType : uint8_t
+    {
+        INT32,
+        UINT32,
+        INT64,
+        UINT64,
+        DOUBLE,
+        STRING,
+        POINTER
+    };
+
+    const char* format;
+    const char* file;
+    int line;
+    int level;
+    uint16_t size;
+    bool truncated;
+    uint8_t payload[PAYLOAD_SIZE];
+
+    void add(const char* text);
+    void add(char* text)
+    {
+        add((const char*)text);
+    }
+
+    // encoded as the type the value is promoted to when passed to printf, so it can be formatted the same way later
+    template<typename T>
+    void add(const T& value)
+    {
+        if constexpr(std::is_array_v<T>)
+        {
+            add(&value[0]);
+        }
+        else if constexpr(std::is_enum_v<T>)
+        {
+            add((std::underlying_type_t<T>)value);
+        }
+        else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            sizeof(T) <= 4 ? addValue(ArgType::INT32, (int32_t)value) : addValue(ArgType::INT64, (int64_t)value);
+        }
+        else if constexpr(std::is_integral_v<T>)
+        {
+            sizeof(T) <= 4 ? addValue(ArgType::UINT32, (uint32_t)value) : addValue(ArgType::UINT64, (uint64_t)value);
+        }
+        else if constexpr(std::is_floating_point_v<T>)
+        {
+            addValue(ArgType::DOUBLE, (double)value);
+        }
+        else
+        {
+            static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+            addValue(ArgType::POINTER, (const void*)value);
+        }
+    }
+
+private:
+    template<typename T>
+    void addValue(ArgType type, T value)
+    {
+        if(size + 1 + sizeof(T) > PAYLOAD_SIZE)
+        {
+            truncated = true;
+            return;
+        }
+        payload[size++] = (uint8_t)type;
+        memcpy(payload + size, &value, sizeof(T));
+        size += sizeof(T);
+    }
+};
+
+// Messages are queued in a fixed ring and formatted and written to stdout by a background thread, so logging from the
+// game never waits on the console. Any number of threads can log without locks. When the ring is full messages are
+// dropped and counted rather than blocking, and the count is reported once there is room again. Asserts and anything
+// logged after the background thread has shut down are written straight away.
+class Logger
+{
+public:
+    static inline const int MAX_MODULES = 64;
+
+    // module names are file names without the directory or extension, e.g. GameState
+    static int registerModule(const char* file);
+    static bool isEnabled(int module, int level)
+    {
+        return level <= moduleLevels[module].load(std::memory_order_relaxed);
+    }
+
+    // Comma separated levels, a bare level sets the default for every module and Module=level overrides one, e.g.
+    // "warn,GameState=debug". Levels are trace, debug, info, warn, error or off. Takes effect immediately.
+    static bool configure(const char* spec);
+
+    // waits until everything logged so far has been written
+    static void flush();
+
+    template<typename... Args>
+    static void write(int level, const char* file, int line, const char* format, const Args&... args)
+    {
+        LogRecord* record = beginRecord(level, file, line, format);
+        if(record != nullptr)
+        {
+            (record->add(args), ...);
+            endRecord(record);
+        }
+    }
+
+private:
+    // a slot in the ring, a scratch record when writing straight away, or nullptr if the ring is full
+    static LogRecord* beginRecord(int level, const char* file, int line, const char* format);
+    static void endRecord(LogRecord* record);
+
+    static inline std::array<std::atomic<int>, MAX_MODULES> moduleLevels {};
+};
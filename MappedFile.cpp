@@ -0,0 +1,123 @@
+#include <SDL.h>
+
+#include "MappedFile.hpp"
+#include "util.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+    HANDLE file =
+        CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Unable to open %s", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        LOG_ERROR("%s is empty or its size can't be read", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    // the mapping keeps the file open, so its handle isn't needed any more
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(m_mapping == nullptr)
+    {
+        LOG_ERROR("Unable to map %s", path);
+        return false;
+    }
+
+    m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_data == nullptr)
+    {
+        LOG_ERROR("Unable to map %s", path);
+        close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+    const int file = ::open(path, O_RDONLY);
+    if(file < 0)
+    {
+        LOG_ERROR("Unable to open %s", path);
+        return false;
+    }
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        LOG_ERROR("%s is empty or its size can't be read", path);
+        ::close(file);
+        return false;
+    }
+
+    // the mapping keeps the file open, so the descriptor isn't needed any more
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if(data == MAP_FAILED)
+    {
+        LOG_ERROR("Unable to map %s", path);
+        return false;
+    }
+
+    m_data = (const uint8_t*)data;
+    m_size = (size_t)status.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(m_data != nullptr)
+    {
+        munmap((void*)m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
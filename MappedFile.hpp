@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A whole file mapped read-only into memory, so large files can be read at random without loading them first
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const char* path);
+    void close();
+
+    const uint8_t* getData() const
+    {
+        return m_data;
+    }
+    size_t getSize() const
+    {
+        return m_size;
+    }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr; // HANDLE, kept out of the header so it doesn't pull in windows.h
+#endif
+};
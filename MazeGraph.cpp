@@ -0,0 +1,113 @@
+#include <algorithm>
+
+#include "MazeGraph.hpp"
+
+static Direction getOpposite(Direction direction)
+{
+    static const Direction OPPOSITES[] = {Direction::DOWN, Direction::UP, Direction::RIGHT, Direction::LEFT};
+    return OPPOSITES[(size_t)direction];
+}
+
+std::shared_ptr<const MazeGraph> MazeGraph::get(const BoardLayout& layout)
+{
+    return getSharedForLayout<MazeGraph>(layout);
+}
+
+MazeGraph::MazeGraph(const BoardLayout& layout) : m_rows((int)layout.size()), m_cols(0)
+{
+    for(const std::string& row : layout)
+    {
+        m_cols = std::max(m_cols, (int)row.size());
+    }
+    const auto isOpen = [&](int row, int col)
+    {
+        return row >= 0 && row < m_rows && col >= 0 && col < (int)layout[row].size() && layout[row][col] != BOUNDARY;
+    };
+
+    m_tiles.resize(m_rows * m_cols);
+    std::vector<GridPosition> junctions;
+    for(int row = 0; row < m_rows; row++)
+    {
+        for(int col = 0; col < m_cols; col++)
+        {
+            if(!isOpen(row, col))
+            {
+                continue;
+            }
+
+            Tile& tile = m_tiles[row * m_cols + col];
+            int exitCount = 0;
+            for(size_t direction = 0; direction < (size_t)Direction::MAX; direction++)
+            {
+                if(isOpen(row + Y_INCREMENT[direction], col + X_INCREMENT[direction]))
+                {
+                    tile.exits |= 1 << direction;
+                    exitCount++;
+                }
+            }
+            if(exitCount != 2)
+            {
+                tile.junction = (int)junctions.size();
+                junctions.push_back({row, col});
+            }
+        }
+    }
+
+    // follow every way out of every junction to the junction at the other end
+    m_junctionCorridors.resize(junctions.size() * (size_t)Direction::MAX, NONE);
+    for(size_t junction = 0; junction < junctions.size(); junction++)
+    {
+        for(size_t leaving = 0; leaving < (size_t)Direction::MAX; leaving++)
+        {
+            int row = junctions[junction].row;
+            int col = junctions[junction].col;
+            if(!canMove(row, col, (Direction)leaving))
+            {
+                continue;
+            }
+
+            Corridor corridor = {(int)junction, (Direction)leaving, NONE, 0, (int)m_steps.size()};
+            Direction facing = (Direction)leaving;
+            while(corridor.toJunction == NONE)
+            {
+                LOG_ASSERT(corridor.length < m_rows * m_cols, "Corridor from junction %zu never ends", junction);
+                row += Y_INCREMENT[(size_t)facing];
+                col += X_INCREMENT[(size_t)facing];
+                Step step = {layout[row][col] == WRAP, facing};
+                if(step.wraps)
+                {
+                    col = (int)layout[row].size() - col - 1;
+                }
+                corridor.toJunction = getJunction(row, col);
+                if(corridor.toJunction == NONE)
+                {
+                    facing = step.next = getWayOn(row, col, facing);
+                }
+                m_steps.push_back(step);
+                corridor.length++;
+            }
+            m_junctionCorridors[junction * (size_t)Direction::MAX + leaving] = (int)m_corridors.size();
+            m_corridors.push_back(corridor);
+        }
+    }
+
+    LOG_INFO("Maze graph with %zu junctions and %zu corridors", junctions.size(), m_corridors.size());
+}
+
+Direction MazeGraph::getWayOn(int row, int col, Direction facing) const
+{
+    // anything but back the way it came, keeping straight on if a mover somehow faces neither way out
+    const uint8_t ahead = getTile(row, col).exits & ~(1 << (size_t)getOpposite(facing));
+    if((ahead & (1 << (size_t)facing)) != 0)
+    {
+        return facing;
+    }
+    for(size_t exit = 0; exit < (size_t)Direction::MAX; exit++)
+    {
+        if((ahead & (1 << exit)) != 0)
+        {
+            return (Direction)exit;
+        }
+    }
+    return facing;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <SDL.h>
+
+#include "util.hpp"
+
+// A layout compiled into junctions and the corridors between them. A junction is any open tile with other than two
+// ways out, where a mover has a choice to make (or, at a dead end, has to turn back). Everywhere else there is only
+// one way forward, so a mover leaving a junction is committed to the whole corridor up to the next one, and every turn
+// along it is worked out here once rather than by the mover on the way.
+//
+// Corridors follow the game's tunnel: stepping onto a WRAP tile carries on from the tile in the mirrored column. Each
+// open tile also keeps which of its neighbours are open, so checking a direction is a bit test rather than indexing
+// into the board.
+class MazeGraph
+{
+public:
+    static inline const int NONE = -1;
+
+    // one tile along a corridor, in the order a mover arrives at them
+    struct Step
+    {
+        bool wraps;     // the tile arrived at is a WRAP tile, the mover carries on from the mirrored column
+        Direction next; // the way on from there, unused for the junction at the end
+    };
+
+    struct Corridor
+    {
+        int fromJunction;
+        Direction leaving; // out of fromJunction
+        int toJunction;
+        int length;    // in tiles, the junction at the end included
+        int firstStep; // of length steps
+    };
+
+    // one graph per wall layout, see getSharedForLayout
+    static std::shared_ptr<const MazeGraph> get(const BoardLayout& layout);
+
+    explicit MazeGraph(const BoardLayout& layout);
+    MazeGraph(MazeGraph&) = delete;
+    MazeGraph& operator=(MazeGraph&) = delete;
+
+    // the neighbouring tile that way is open, anything off the board counts as a wall
+    bool canMove(int row, int col, Direction direction) const
+    {
+        return (getTile(row, col).exits & (1 << (size_t)direction)) != 0;
+    }
+    bool isJunction(int row, int col) const
+    {
+        return getTile(row, col).junction != NONE;
+    }
+    int getJunction(int row, int col) const
+    {
+        return getTile(row, col).junction;
+    }
+
+    // The corridor out of a junction the given way, NONE if that way is a wall. Corridors are numbered from 0, so a
+    // mover can keep the one it's on as a plain number.
+    int findCorridor(int junction, Direction leaving) const
+    {
+        return m_junctionCorridors[junction * (size_t)Direction::MAX + (size_t)leaving];
+    }
+    const Corridor& getCorridor(int corridor) const
+    {
+        return m_corridors[corridor];
+    }
+    const Step& getStep(const Corridor& corridor, int step) const
+    {
+        return m_steps[corridor.firstStep + step];
+    }
+
+    // The way on from a corridor tile entered facing the given direction, round a bend if need be, for a mover that
+    // was put down partway along a corridor. Only meaningful away from junctions.
+    Direction getWayOn(int row, int col, Direction facing) const;
+
+private:
+    struct Tile
+    {
+        uint8_t exits = 0; // a bit per direction
+        int junction = NONE;
+    };
+
+    const Tile& getTile(int row, int col) const
+    {
+        // off the board is a tile with no way out
+        static const Tile OUTSIDE;
+        if(row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+        {
+            return OUTSIDE;
+        }
+        return m_tiles[row * m_cols + col];
+    }
+
+    int m_rows;
+    int m_cols;
+    std::vector<Tile> m_tiles; // per board position
+    std::vector<int> m_junctionCorridors; // per junction and direction
+    std::vector<Corridor> m_corridors;
+    std::vector<Step> m_steps;
+};
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <queue>
+
+#include "Navigation.hpp"
+
+std::shared_ptr<const NavigationTable> NavigationTable::get(const BoardLayout& layout)
+{
+    return getSharedForLayout<NavigationTable>(layout);
+}
+
+NavigationTable::NavigationTable(const BoardLayout& layout) : m_rows((int)layout.size()), m_cols(0)
+{
+    for(const std::string& row : layout)
+    {
+        m_cols = std::max(m_cols, (int)row.size());
+    }
+    const auto isOpen = [&](int row, int col)
+    {
+        return row >= 0 && row < m_rows && col >= 0 && col < (int)layout[row].size() && layout[row][col] != BOUNDARY;
+    };
+
+    // every open tile to start with, cut down to the maze once the paths are known
+    std::vector<GridPosition> openTiles;
+    std::vector<int> openIndices(m_rows * m_cols, -1);
+    for(int row = 0; row < m_rows; row++)
+    {
+        for(int col = 0; col < m_cols; col++)
+        {
+            if(isOpen(row, col))
+            {
+                openIndices[row * m_cols + col] = (int)openTiles.size();
+                openTiles.push_back({row, col});
+            }
+        }
+    }
+    const size_t openCount = openTiles.size();
+    LOG_ASSERT(openCount < (1 << (16 - DIRECTION_BITS)), "%zu open tiles, distances won't fit", openCount);
+
+    // where one step in a direction ends up, or -1 if it can't be taken
+    const auto step = [&](const GridPosition& from, Direction direction)
+    {
+        const int xIncrement = X_INCREMENT[(size_t)direction];
+        if(layout[from.row][from.col] == WRAP && xIncrement == (from.col < m_cols / 2 ? -1 : 1))
+        {
+            return -1;
+        }
+        const int row = from.row + Y_INCREMENT[(size_t)direction];
+        int col = from.col + xIncrement;
+        if(!isOpen(row, col))
+        {
+            return -1;
+        }
+        if(layout[row][col] == WRAP)
+        {
+            col = (int)layout[row].size() - col - 1;
+        }
+        return isOpen(row, col) ? openIndices[row * m_cols + col] : -1;
+    };
+
+    // The first step is passed along to every tile found through it. Directions are always tried in the same order,
+    // so of several equally short paths the same one is always picked.
+    std::vector<uint16_t> openEntries(openCount * openCount, NO_PATH);
+    std::queue<int> queue;
+    for(size_t source = 0; source < openCount; source++)
+    {
+        uint16_t* entries = &openEntries[source * openCount];
+        entries[source] = 0;
+        queue.push((int)source);
+        while(!queue.empty())
+        {
+            const int current = queue.front();
+            queue.pop();
+            const uint16_t distance = entries[current] >> DIRECTION_BITS;
+            for(size_t direction = 0; direction < (size_t)Direction::MAX; direction++)
+            {
+                const int next = step(openTiles[current], (Direction)direction);
+                if(next < 0 || entries[next] != NO_PATH)
+                {
+                    continue;
+                }
+                const uint16_t firstStep = current == (int)source ? direction : entries[current] & DIRECTION_MASK;
+                entries[next] = (uint16_t)((distance + 1) << DIRECTION_BITS | firstStep);
+                queue.push(next);
+            }
+        }
+    }
+
+    // the maze is the biggest group of tiles that can all get to each other
+    const auto connected = [&](size_t a, size_t b)
+    {
+        return openEntries[a * openCount + b] != NO_PATH && openEntries[b * openCount + a] != NO_PATH;
+    };
+    size_t mazeTile = 0;
+    size_t mazeSize = 0;
+    for(size_t tile = 0; tile < openCount; tile++)
+    {
+        size_t size = 0;
+        for(size_t other = 0; other < openCount; other++)
+        {
+            size += connected(tile, other) ? 1 : 0;
+        }
+        if(size > mazeSize)
+        {
+            mazeTile = tile;
+            mazeSize = size;
+        }
+    }
+
+    // A shortest path between two maze tiles never leaves the maze, everything on it can get to both ends, so the
+    // entries carry over as they are.
+    std::vector<size_t> mazeToOpen;
+    m_tileIndices.assign(m_rows * m_cols, -1);
+    for(size_t tile = 0; tile < openCount; tile++)
+    {
+        if(connected(mazeTile, tile))
+        {
+            m_tileIndices[openTiles[tile].row * m_cols + openTiles[tile].col] = (int)m_tiles.size();
+            m_tiles.push_back(openTiles[tile]);
+            mazeToOpen.push_back(tile);
+        }
+    }
+    m_entries.resize(m_tiles.size() * m_tiles.size());
+    for(size_t from = 0; from < m_tiles.size(); from++)
+    {
+        for(size_t to = 0; to < m_tiles.size(); to++)
+        {
+            m_entries[from * m_tiles.size() + to] = openEntries[mazeToOpen[from] * openCount + mazeToOpen[to]];
+        }
+    }
+
+    // straight line distance, ties going to the first tile in reading order
+    m_nearestTiles.resize(m_rows * m_cols);
+    for(int row = 0; row < m_rows; row++)
+    {
+        for(int col = 0; col < m_cols; col++)
+        {
+            int nearest = 0;
+            int nearestDistance = INT32_MAX;
+            for(size_t tile = 0; tile < m_tiles.size(); tile++)
+            {
+                const int rowDistance = m_tiles[tile].row - row;
+                const int colDistance = m_tiles[tile].col - col;
+                const int distance = rowDistance * rowDistance + colDistance * colDistance;
+                if(distance < nearestDistance)
+                {
+                    nearest = (int)tile;
+                    nearestDistance = distance;
+                }
+            }
+            m_nearestTiles[row * m_cols + col] = nearest;
+        }
+    }
+
+    LOG_INFO(
+        "Navigation table for %zu of %zu open tiles, %zu KB",
+        m_tiles.size(),
+        openCount,
+        m_entries.size() * sizeof(uint16_t) / 1024);
+}
+
+GridPosition NavigationTable::getNearestTile(const GridPosition& position) const
+{
+    const int row = std::clamp(position.row, 0, m_rows - 1);
+    const int col = std::clamp(position.col, 0, m_cols - 1);
+    return m_tiles[m_nearestTiles[row * m_cols + col]];
+}
+
+std::optional<Direction> NavigationTable::getNextDirection(const GridPosition& from, const GridPosition& to) const
+{
+    const int fromIndex = getTileIndex(from.row, from.col);
+    if(fromIndex < 0)
+    {
+        return std::nullopt;
+    }
+    const int row = std::clamp(to.row, 0, m_rows - 1);
+    const int col = std::clamp(to.col, 0, m_cols - 1);
+    const int toIndex = m_nearestTiles[row * m_cols + col];
+    if(fromIndex == toIndex)
+    {
+        return std::nullopt;
+    }
+    return (Direction)(getEntry(fromIndex, toIndex) & DIRECTION_MASK);
+}
+
+int NavigationTable::getDistance(const GridPosition& from, const GridPosition& to) const
+{
+    const int fromIndex = getTileIndex(from.row, from.col);
+    const int toIndex = getTileIndex(to.row, to.col);
+    if(fromIndex < 0 || toIndex < 0)
+    {
+        return UNREACHABLE;
+    }
+    return getEntry(fromIndex, toIndex) >> DIRECTION_BITS;
+}
+
+int NavigationTable::getTileIndex(int row, int col) const
+{
+    if(row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+    {
+        return -1;
+    }
+    return m_tileIndices[row * m_cols + col];
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <SDL.h>
+
+#include "util.hpp"
+
+// Shortest paths between every pair of tiles in a maze, worked out once with a breadth first search from each tile,
+// so a ghost only has to look up which way to go. Stepping onto a WRAP tile carries on from the tile in the mirrored
+// column, the same as the game does; leaving a WRAP tile outwards goes nowhere, since the game never puts anything
+// past one.
+//
+// Only the maze proper is kept, the largest set of tiles that can all reach each other. Open tiles walled off from it,
+// like the ghost box and the space around the board, aren't part of any path. Each pair is a 16 bit entry holding the
+// distance and the first step, about 170 KB for BASE_LAYOUT.
+class NavigationTable
+{
+public:
+    static inline const int UNREACHABLE = -1;
+
+    // one table per wall layout, see getSharedForLayout
+    static std::shared_ptr<const NavigationTable> get(const BoardLayout& layout);
+
+    explicit NavigationTable(const BoardLayout& layout);
+    NavigationTable(NavigationTable&) = delete;
+    NavigationTable& operator=(NavigationTable&) = delete;
+
+    // the closest maze tile to any position, on the board or not, for targets that land on a wall or off the board
+    GridPosition getNearestTile(const GridPosition& position) const;
+
+    // The first step of a shortest path, after moving the target to the nearest maze tile. Nothing if from is already
+    // there or isn't in the maze.
+    std::optional<Direction> getNextDirection(const GridPosition& from, const GridPosition& to) const;
+
+    // number of steps between two maze tiles, UNREACHABLE if either isn't one
+    int getDistance(const GridPosition& from, const GridPosition& to) const;
+
+    size_t getTileCount() const
+    {
+        return m_tiles.size();
+    }
+
+private:
+    // the first step in the low bits, the distance above them
+    static inline const int DIRECTION_BITS = 2;
+    static inline const uint16_t DIRECTION_MASK = (1 << DIRECTION_BITS) - 1;
+    static inline const uint16_t NO_PATH = UINT16_MAX;
+
+    // index into m_tiles, or -1 for walls, walled off tiles and anything off the board
+    int getTileIndex(int row, int col) const;
+    uint16_t getEntry(int fromIndex, int toIndex) const
+    {
+        return m_entries[(size_t)fromIndex * m_tiles.size() + toIndex];
+    }
+
+    int m_rows;
+    int m_cols;
+    std::vector<GridPosition> m_tiles;
+    std::vector<int> m_tileIndices;  // per board position
+    std::vector<int> m_nearestTiles; // per board position
+    std::vector<uint16_t> m_entries; // per pair of tiles, from then to
+};
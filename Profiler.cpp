@@ -0,0 +1,267 @@
+#include "Profiler.hpp"
+
+#if PACMAN_PROFILER
+
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include "util.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // log scale buckets of counter ticks, four per power of two, so percentiles are within about 20%
+    const int SUB_BUCKET_BITS = 2;
+    const int NUM_BUCKETS = 64 << SUB_BUCKET_BITS;
+
+    // Only the owning thread writes these, the atomics just make reading them from the report thread safe. Relaxed
+    // loads and stores compile to plain moves, so there is no locked instruction on the recording path.
+    struct ZoneStats
+    {
+        std::atomic<uint64_t> count {0};
+        std::atomic<uint64_t> total {0};
+        std::atomic<uint64_t> max {0};
+        std::array<std::atomic<uint32_t>, NUM_BUCKETS> buckets {};
+    };
+
+    struct ThreadProfile
+    {
+        std::array<ZoneStats, Profiler::MAX_ZONES> zones;
+    };
+
+    // registration only happens once per zone and per thread, so these locks are off the hot path
+    std::mutex zoneMutex;
+    std::array<const char*, Profiler::MAX_ZONES> zoneNames {};
+    std::atomic<int> zoneCount {0};
+
+    std::mutex threadMutex;
+    std::vector<std::unique_ptr<ThreadProfile>> threadProfiles; // kept after threads exit, for the report
+    thread_local ThreadProfile* currentThreadProfile = nullptr;
+
+    // render thread only
+    const size_t FRAME_HISTORY = 240;
+    std::vector<float> recentFrameMs;
+    uint64_t lastFrameTime = 0;
+    int frameZoneId = -1;
+
+    // counterTicks must be non-zero
+    int getHighestBit(uint64_t counterTicks)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(counterTicks);
+#elif defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanReverse64(&bit, counterTicks);
+        return (int)bit;
+#else
+        int bit = 63;
+        while((counterTicks >> bit) == 0)
+        {
+            bit--;
+        }
+        return bit;
+#endif
+    }
+
+    int getBucket(uint64_t counterTicks)
+    {
+        if(counterTicks < (1u << SUB_BUCKET_BITS))
+        {
+            return (int)counterTicks;
+        }
+        const int octave = getHighestBit(counterTicks);
+        const int subBucket = (int)(counterTicks >> (octave - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+        return ((octave - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+    }
+
+    // middle of the range of counter ticks that land in the bucket
+    double getBucketMidpoint(int bucket)
+    {
+        if(bucket < (1 << SUB_BUCKET_BITS))
+        {
+            return bucket;
+        }
+        const int octave = (bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+        const int subBucket = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+        const double low = (double)((1ull << octave) + ((uint64_t)subBucket << (octave - SUB_BUCKET_BITS)));
+        return low + (double)(1ull << (octave - SUB_BUCKET_BITS)) / 2;
+    }
+
+    ThreadProfile& getThreadProfile()
+    {
+        if(currentThreadProfile == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(threadMutex);
+            threadProfiles.push_back(std::make_unique<ThreadProfile>());
+            currentThreadProfile = threadProfiles.back().get();
+        }
+        return *currentThreadProfile;
+    }
+
+    template<typename T>
+    void addRelaxed(std::atomic<T>& value, T amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+}
+
+int Profiler::registerZone(const char* name)
+{
+    std::lock_guard<std::mutex> lock(zoneMutex);
+    const int count = zoneCount.load();
+    for(int zoneId = 0; zoneId < count; zoneId++)
+    {
+        if(strcmp(zoneNames[zoneId], name) == 0)
+        {
+            return zoneId;
+        }
+    }
+    if(count == MAX_ZONES)
+    {
+        LOG_WARN("Too many profiler zones, %s won't be recorded", name);
+        return -1;
+    }
+    zoneNames[count] = name;
+    zoneCount.store(count + 1);
+    return count;
+}
+
+void Profiler::record(int zoneId, uint64_t counterTicks)
+{
+    if(zoneId < 0)
+    {
+        return;
+    }
+
+    ZoneStats& zone = getThreadProfile().zones[zoneId];
+    addRelaxed<uint64_t>(zone.count, 1);
+    addRelaxed(zone.total, counterTicks);
+    addRelaxed<uint32_t>(zone.buckets[getBucket(counterTicks)], 1);
+    if(counterTicks > zone.max.load(std::memory_order_relaxed))
+    {
+        zone.max.store(counterTicks, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::onFrame()
+{
+    if(!isEnabled())
+    {
+        // so the first frame timed isn't measured from long before
+        lastFrameTime = 0;
+        return;
+    }
+    if(frameZoneId < 0)
+    {
+        frameZoneId = registerZone("frame");
+    }
+
+    const uint64_t frameTime = now();
+    if(lastFrameTime != 0)
+    {
+        const uint64_t frameTicks = frameTime - lastFrameTime;
+        record(frameZoneId, frameTicks);
+        if(recentFrameMs.size() == FRAME_HISTORY)
+        {
+            recentFrameMs.erase(recentFrameMs.begin());
+        }
+        recentFrameMs.push_back((float)((double)frameTicks * 1000.0 / SDL_GetPerformanceFrequency()));
+    }
+    lastFrameTime = frameTime;
+}
+
+double Profiler::getFramesPerSecond()
+{
+    // averaged over the last second's worth of frames
+    double totalMs = 0.0;
+    int frames = 0;
+    for(auto it = recentFrameMs.rbegin(); it != recentFrameMs.rend() && totalMs < 1000.0; ++it)
+    {
+        totalMs += *it;
+        frames++;
+    }
+    return totalMs > 0.0 ? frames * 1000.0 / totalMs : 0.0;
+}
+
+const std::vector<float>& Profiler::getRecentFrameMs()
+{
+    return recentFrameMs;
+}
+
+bool Profiler::writeReport(const char* path)
+{
+    std::ofstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to write profile report %s", path);
+        return false;
+    }
+
+    const double microsecondsPerTick = 1e6 / SDL_GetPerformanceFrequency();
+    std::lock_guard<std::mutex> lock(threadMutex);
+    file << "zone,calls,total_ms,mean_us,p50_us,p95_us,p99_us,max_us\n";
+    const int count = zoneCount.load();
+    for(int zoneId = 0; zoneId < count; zoneId++)
+    {
+        uint64_t calls = 0;
+        uint64_t total = 0;
+        uint64_t max = 0;
+        std::array<uint64_t, NUM_BUCKETS> buckets {};
+        for(const auto& thread : threadProfiles)
+        {
+            const ZoneStats& zone = thread->zones[zoneId];
+            calls += zone.count.load(std::memory_order_relaxed);
+            total += zone.total.load(std::memory_order_relaxed);
+            max = std::max(max, zone.max.load(std::memory_order_relaxed));
+            for(int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            {
+                buckets[bucket] += zone.buckets[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        if(calls == 0)
+        {
+            continue;
+        }
+
+        const auto percentileUs = [&](double fraction)
+        {
+            const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(fraction * calls + 0.5));
+            uint64_t seen = 0;
+            for(int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            {
+                seen += buckets[bucket];
+                if(seen >= rank)
+                {
+                    return std::min(getBucketMidpoint(bucket), (double)max) * microsecondsPerTick;
+                }
+            }
+            return max * microsecondsPerTick;
+        };
+
+        file << zoneNames[zoneId] << ',' << calls << ',' << total * microsecondsPerTick / 1000.0 << ','
+             << (double)total / calls * microsecondsPerTick << ',' << percentileUs(0.50) << ',' << percentileUs(0.95)
+             << ',' << percentileUs(0.99) << ',' << max * microsecondsPerTick << '\n';
+    }
+
+    LOG_INFO("Wrote profile report to %s", path);
+    return true;
+}
+
+#else
+
+#include "Logger.hpp"
+
+void Profiler::enable()
+{
+    LOG_WARN("Profiling needs a build with PACMAN_PROFILER on");
+}
+
+#endif
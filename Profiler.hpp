@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <SDL.h>
+
+#include "TraceRecorder.hpp"
+
+// Scoped timing zones for the running game. Each thread accumulates into its own histograms, which only that thread
+// writes, so recording a zone takes no locks. The report merges every thread's histograms into p50/p95/p99 per zone.
+//
+// Zones are only timed once something asks for the results: --profile, --trace or the overlay. Until then a zone is
+// one relaxed load, so builds with the profiler in still run full speed when nobody is looking. Configuring with
+// -DPACMAN_PROFILER=OFF compiles all of it out: zones expand to nothing and the rest are no-ops.
+
+#if PACMAN_PROFILER
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// times the rest of the enclosing scope, zones with the same name are reported together
+#define PROFILE_ZONE(name) PROFILE_ZONE_ARG(name, TraceRecorder::NO_ARG)
+
+// the same, with a value shown on the zone's span in a trace
+#define PROFILE_ZONE_ARG(name, arg)                                                          \
+    static const int PROFILE_CONCAT(profileZoneId, __LINE__) = Profiler::registerZone(name); \
+    const ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__), name, arg)
+
+class Profiler
+{
+public:
+    static inline const int MAX_ZONES = 64;
+
+    static int registerZone(const char* name);
+
+    // turns on timing zones and frames for the rest of the run
+    static void enable()
+    {
+        enabled.store(true, std::memory_order_relaxed);
+    }
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Zones are timed in raw performance counter units and only converted for reports, which keeps divisions off the
+    // recording path. This only ever measures real time, so it doesn't go through the game's Clock.
+    static uint64_t now()
+    {
+        return SDL_GetPerformanceCounter();
+    }
+    static void record(int zoneId, uint64_t counterTicks);
+
+    // called once per presented frame from the render thread, the frame times are kept for the overlay
+    static void onFrame();
+    static double getFramesPerSecond();
+    static const std::vector<float>& getRecentFrameMs(); // oldest first
+
+    // one line per zone with call count, total and percentiles, merged across threads
+    static bool writeReport(const char* path);
+
+private:
+    static inline std::atomic<bool> enabled {false};
+};
+
+class ProfileZone
+{
+public:
+    ProfileZone(int zoneId, const char* name, int64_t traceArg)
+    : m_zoneId(zoneId), m_name(name), m_traceArg(traceArg), m_enabled(Profiler::isEnabled()),
+      m_start(m_enabled ? Profiler::now() : 0)
+    {
+    }
+    ProfileZone(ProfileZone&) = delete;
+    ProfileZone& operator=(ProfileZone&) = delete;
+    ~ProfileZone()
+    {
+        if(!m_enabled)
+        {
+            return;
+        }
+        const uint64_t end = Profiler::now();
+        Profiler::record(m_zoneId, end - m_start);
+        if(TraceRecorder::isRecording())
+        {
+            TraceRecorder::recordSpan(m_name, m_start, end, m_traceArg);
+        }
+    }
+
+private:
+    int m_zoneId;
+    const char* m_name;
+    int64_t m_traceArg;
+    bool m_enabled;
+    uint64_t m_start;
+};
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_ARG(name, arg)
+
+class Profiler
+{
+public:
+    // only warns that there is nothing to turn on
+    static void enable();
+    static bool isEnabled()
+    {
+        return false;
+    }
+    static void onFrame() {}
+    static double getFramesPerSecond()
+    {
+        return 0.0;
+    }
+    static const std::vector<float>& getRecentFrameMs()
+    {
+        static const std::vector<float> none;
+        return none;
+    }
+    static bool writeReport(const char*)
+    {
+        return false;
+    }
+};
+
+#endif
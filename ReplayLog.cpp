@@ -0,0 +1,362 @@
+#include <string.h>
+#include <algorithm>
+
+#include "ReplayLog.hpp"
+#include "util.hpp"
+
+static const char MAGIC[4] = {'P', 'M', 'R', 'L'};
+static const char INDEX_MAGIC[4] = {'P', 'M', 'R', 'I'};
+static const uint32_t FORMAT_VERSION = 8;
+static const size_t HEADER_SIZE = sizeof(MAGIC) + 4 + 4 + 4 + 8;
+static const size_t FOOTER_SIZE = 8 + 8 + 8 + sizeof(INDEX_MAGIC);
+static const size_t INDEX_ENTRY_SIZE = 8 + 8;
+static const uint8_t PRESSED_BIT = 0x80;
+
+static void writeInteger(std::ofstream& file, uint64_t value, int bytes)
+{
+    for(int byte = 0; byte < bytes; byte++)
+    {
+        file.put((char)(uint8_t)(value >> (8 * byte)));
+    }
+}
+
+// reads from the mapped file, failing rather than reading past end
+static bool readInteger(const uint8_t* data, size_t end, size_t& offset, uint64_t& value, int bytes)
+{
+    if(offset + bytes > end)
+    {
+        return false;
+    }
+    value = 0;
+    for(int byte = 0; byte < bytes; byte++)
+    {
+        value |= (uint64_t)data[offset++] << (8 * byte);
+    }
+    return true;
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+bool ReplayWriter::open(const char* path, const GameState& gameState, uint32_t keyframeInterval)
+{
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_file)
+    {
+        LOG_ERROR("Unable to create replay log %s", path);
+        return false;
+    }
+
+    m_keyframeInterval = std::max<uint32_t>(1, keyframeInterval);
+    m_ticksWritten = 0;
+    m_keyframes.clear();
+
+    m_file.write(MAGIC, sizeof(MAGIC));
+    writeInteger(m_file, FORMAT_VERSION, 4);
+    writeInteger(m_file, GameState::TICKS_PER_SECOND, 4);
+    writeInteger(m_file, m_keyframeInterval, 4);
+    writeInteger(m_file, gameState.computeStateHash(), 8);
+    writeKeyframe(gameState);
+    LOG_INFO("Recording input to %s", path);
+    return true;
+}
+
+void ReplayWriter::writeTick(const std::vector<InputEvent>& inputs, const GameState& gameState)
+{
+    // a key can only change state so many times in a tick, anything past this is repeats
+    const size_t count = std::min<size_t>(inputs.size(), UINT8_MAX);
+    if(count < inputs.size())
+    {
+        LOG_WARN("Dropping %zu inputs from the replay log", inputs.size() - count);
+    }
+
+    m_file.put((char)count);
+    for(size_t index = 0; index < count; index++)
+    {
+        m_file.put((char)((uint8_t)inputs[index].direction | (inputs[index].pressed ? PRESSED_BIT : 0)));
+    }
+    writeInteger(m_file, gameState.computeStateHash(), 8);
+
+    m_ticksWritten++;
+    if(m_ticksWritten % m_keyframeInterval == 0)
+    {
+        writeKeyframe(gameState);
+    }
+}
+
+void ReplayWriter::writeKeyframe(const GameState& gameState)
+{
+    m_keyframeBytes.clear();
+    gameState.saveState(m_keyframeBytes);
+
+    m_keyframes.push_back({m_ticksWritten, (uint64_t)m_file.tellp()});
+    writeInteger(m_file, m_keyframeBytes.size(), 4);
+    m_file.write((const char*)m_keyframeBytes.data(), (std::streamsize)m_keyframeBytes.size());
+}
+
+void ReplayWriter::close()
+{
+    if(!m_file.is_open())
+    {
+        return;
+    }
+
+    const uint64_t indexOffset = (uint64_t)m_file.tellp();
+    for(const KeyframeEntry& keyframe : m_keyframes)
+    {
+        writeInteger(m_file, keyframe.tick, 8);
+        writeInteger(m_file, keyframe.offset, 8);
+    }
+    writeInteger(m_file, indexOffset, 8);
+    writeInteger(m_file, m_keyframes.size(), 8);
+    writeInteger(m_file, m_ticksWritten, 8);
+    m_file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    m_file.close();
+    LOG_INFO("Recorded %llu ticks, %zu keyframes", (unsigned long long)m_ticksWritten, m_keyframes.size());
+}
+
+bool ReplayReader::open(const char* path)
+{
+    m_path = path;
+    m_keyframes.clear();
+    if(!m_file.open(path))
+    {
+        return false;
+    }
+
+    const uint8_t* data = m_file.getData();
+    const size_t size = m_file.getSize();
+    size_t offset = sizeof(MAGIC);
+    uint64_t version = 0;
+    uint64_t ticksPerSecond = 0;
+    uint64_t keyframeInterval = 0;
+    if(size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || !readInteger(data, size, offset, version, 4))
+    {
+        LOG_ERROR("%s is not a replay log", path);
+        return false;
+    }
+    if(version != FORMAT_VERSION)
+    {
+        LOG_ERROR("%s has format version %llu, expected %u", path, (unsigned long long)version, FORMAT_VERSION);
+        return false;
+    }
+
+    readInteger(data, size, offset, ticksPerSecond, 4);
+    readInteger(data, size, offset, keyframeInterval, 4);
+    readInteger(data, size, offset, m_initialStateHash, 8);
+    if(ticksPerSecond != (uint64_t)GameState::TICKS_PER_SECOND)
+    {
+        LOG_ERROR(
+            "%s was recorded at %llu ticks per second, this build runs %d",
+            path,
+            (unsigned long long)ticksPerSecond,
+            GameState::TICKS_PER_SECOND);
+        return false;
+    }
+    if(keyframeInterval == 0)
+    {
+        LOG_ERROR("%s has no keyframe interval", path);
+        return false;
+    }
+    m_keyframeInterval = (uint32_t)keyframeInterval;
+    m_bodyStart = offset;
+
+    if(!readFooter() && !scanKeyframes())
+    {
+        return false;
+    }
+
+    m_offset = m_bodyStart;
+    m_nextTick = 0;
+    return true;
+}
+
+bool ReplayReader::readFooter()
+{
+    const uint8_t* data = m_file.getData();
+    const size_t size = m_file.getSize();
+    if(size < m_bodyStart + FOOTER_SIZE
+       || memcmp(data + size - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    {
+        return false;
+    }
+
+    size_t offset = size - FOOTER_SIZE;
+    uint64_t indexOffset = 0;
+    uint64_t keyframeCount = 0;
+    readInteger(data, size, offset, indexOffset, 8);
+    readInteger(data, size, offset, keyframeCount, 8);
+    readInteger(data, size, offset, m_tickCount, 8);
+    if(indexOffset < m_bodyStart || indexOffset + keyframeCount * INDEX_ENTRY_SIZE != size - FOOTER_SIZE)
+    {
+        LOG_WARN("%s: keyframe index is damaged", m_path.c_str());
+        return false;
+    }
+
+    offset = (size_t)indexOffset;
+    m_keyframes.resize((size_t)keyframeCount);
+    for(KeyframeEntry& keyframe : m_keyframes)
+    {
+        readInteger(data, size, offset, keyframe.tick, 8);
+        readInteger(data, size, offset, keyframe.offset, 8);
+    }
+    m_bodyEnd = (size_t)indexOffset;
+    return true;
+}
+
+bool ReplayReader::scanKeyframes()
+{
+    // no usable index, e.g. the game was killed while recording, so find the keyframes the slow way
+    LOG_WARN("%s has no keyframe index, scanning the whole log", m_path.c_str());
+    m_keyframes.clear();
+    m_bodyEnd = m_file.getSize();
+
+    std::vector<InputEvent> inputs;
+    uint64_t stateHash = 0;
+    size_t offset = m_bodyStart;
+    for(m_tickCount = 0;; m_tickCount++)
+    {
+        if(m_tickCount % m_keyframeInterval == 0)
+        {
+            const size_t keyframeOffset = offset;
+            const uint8_t* state = nullptr;
+            uint32_t stateSize = 0;
+            if(!readKeyframe(offset, state, stateSize))
+            {
+                break;
+            }
+            m_keyframes.push_back({m_tickCount, keyframeOffset});
+        }
+        if(!readTickAt(offset, inputs, stateHash))
+        {
+            break;
+        }
+    }
+
+    if(m_keyframes.empty())
+    {
+        LOG_ERROR("%s has no keyframes", m_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReplayReader::readKeyframe(size_t& offset, const uint8_t*& state, uint32_t& size) const
+{
+    uint64_t stateSize = 0;
+    if(!readInteger(m_file.getData(), m_bodyEnd, offset, stateSize, 4) || offset + stateSize > m_bodyEnd)
+    {
+        return false;
+    }
+    state = m_file.getData() + offset;
+    size = (uint32_t)stateSize;
+    offset += (size_t)stateSize;
+    return true;
+}
+
+bool ReplayReader::readTickAt(size_t& offset, std::vector<InputEvent>& inputs, uint64_t& stateHash) const
+{
+    const uint8_t* data = m_file.getData();
+    inputs.clear();
+
+    uint64_t count = 0;
+    if(!readInteger(data, m_bodyEnd, offset, count, 1))
+    {
+        return false;
+    }
+    for(uint64_t index = 0; index < count; index++)
+    {
+        uint64_t packed = 0;
+        if(!readInteger(data, m_bodyEnd, offset, packed, 1) || (packed & ~PRESSED_BIT) >= (uint64_t)Direction::MAX)
+        {
+            LOG_WARN("%s: bad input record", m_path.c_str());
+            return false;
+        }
+        inputs.push_back({(Direction)(packed & ~PRESSED_BIT), (packed & PRESSED_BIT) != 0});
+    }
+    return readInteger(data, m_bodyEnd, offset, stateHash, 8);
+}
+
+bool ReplayReader::readTick(std::vector<InputEvent>& inputs, uint64_t& stateHash)
+{
+    if(m_nextTick >= m_tickCount)
+    {
+        return false;
+    }
+
+    size_t offset = m_offset;
+    if(m_nextTick % m_keyframeInterval == 0)
+    {
+        const uint8_t* state = nullptr;
+        uint32_t stateSize = 0;
+        if(!readKeyframe(offset, state, stateSize))
+        {
+            LOG_WARN("%s: missing keyframe before tick %llu", m_path.c_str(), (unsigned long long)m_nextTick);
+            return false;
+        }
+    }
+    if(!readTickAt(offset, inputs, stateHash))
+    {
+        LOG_WARN("%s: log is truncated at tick %llu", m_path.c_str(), (unsigned long long)m_nextTick);
+        return false;
+    }
+
+    m_offset = offset;
+    m_nextTick++;
+    return true;
+}
+
+bool ReplayReader::seek(uint64_t tick, GameState& gameState)
+{
+    if(tick > m_tickCount)
+    {
+        LOG_ERROR(
+            "Can't seek to tick %llu, the log has %llu",
+            (unsigned long long)tick,
+            (unsigned long long)m_tickCount);
+        return false;
+    }
+
+    // the last keyframe at or before the tick, there's always one for tick 0
+    const auto after = std::upper_bound(
+        m_keyframes.begin(),
+        m_keyframes.end(),
+        tick,
+        [](uint64_t tick, const KeyframeEntry& keyframe) { return tick < keyframe.tick; });
+    if(after == m_keyframes.begin())
+    {
+        LOG_ERROR("%s has no keyframe at or before tick %llu", m_path.c_str(), (unsigned long long)tick);
+        return false;
+    }
+    const KeyframeEntry& keyframe = *(after - 1);
+
+    size_t offset = (size_t)keyframe.offset;
+    const uint8_t* state = nullptr;
+    uint32_t stateSize = 0;
+    if(!readKeyframe(offset, state, stateSize) || !gameState.restoreState(state, stateSize))
+    {
+        LOG_ERROR("%s: bad keyframe for tick %llu", m_path.c_str(), (unsigned long long)keyframe.tick);
+        return false;
+    }
+
+    // reading on from the keyframe steps over it like any other
+    m_offset = (size_t)keyframe.offset;
+    m_nextTick = keyframe.tick;
+    std::vector<InputEvent> inputs;
+    uint64_t stateHash = 0;
+    while(m_nextTick < tick)
+    {
+        if(!readTick(inputs, stateHash))
+        {
+            return false;
+        }
+        for(const InputEvent& input : inputs)
+        {
+            gameState.handleInput(input);
+        }
+        gameState.tick();
+    }
+    return true;
+}
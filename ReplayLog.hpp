@@ -0,0 +1,108 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "GameState.hpp"
+#include "MappedFile.hpp"
+
+// Compact binary log of a game's input, for reproducing a run exactly. It starts with a header:
+//     "PMRL", format version (u32), ticks per second (u32), keyframe interval (u32), hash of the starting state (u64)
+// followed by one record per tick:
+//     input count (u8), one byte per input (direction in the low bits, 0x80 if pressed),
+//     state hash after the tick (u64)
+// Before every tick that is a multiple of the keyframe interval, tick 0 included, there is a keyframe holding the
+// whole game state at that point (GameState::saveState):
+//     size (u32), state
+// and the file ends with an index of the keyframes:
+//     (tick (u64), file offset (u64)) per keyframe, index offset (u64), keyframe count (u64), tick count (u64), "PMRI"
+// Inputs in a record are applied, in order, before that tick runs. Integers are little endian.
+//
+// Since the game is deterministic given its input, feeding the records back reproduces the run, and the stored
+// hashes show the first tick at which a replay stops matching the recording. Keyframes let a replay start anywhere
+// without simulating everything before it.
+
+class ReplayWriter
+{
+public:
+    static inline const uint32_t DEFAULT_KEYFRAME_INTERVAL = GameState::TICKS_PER_SECOND * 10;
+
+    ReplayWriter() = default;
+    ReplayWriter(ReplayWriter&) = delete;
+    ReplayWriter& operator=(ReplayWriter&) = delete;
+    ~ReplayWriter();
+
+    bool open(const char* path, const GameState& gameState, uint32_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+    void writeTick(const std::vector<InputEvent>& inputs, const GameState& gameState);
+
+    // writes the index, a log that was never closed can still be read but has to be scanned to find its keyframes
+    void close();
+
+private:
+    void writeKeyframe(const GameState& gameState);
+
+    struct KeyframeEntry
+    {
+        uint64_t tick;
+        uint64_t offset;
+    };
+
+    std::ofstream m_file;
+    uint32_t m_keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+    uint64_t m_ticksWritten = 0;
+    std::vector<KeyframeEntry> m_keyframes;
+    std::vector<uint8_t> m_keyframeBytes; // reused between keyframes
+};
+
+// Reads a log through a memory mapping, so seeking within a long recording doesn't read the rest of the file
+class ReplayReader
+{
+public:
+    bool open(const char* path);
+    uint64_t getInitialStateHash() const
+    {
+        return m_initialStateHash;
+    }
+    uint64_t getTickCount() const
+    {
+        return m_tickCount;
+    }
+
+    // the tick the next readTick returns
+    uint64_t getNextTick() const
+    {
+        return m_nextTick;
+    }
+
+    // false at the end of the log
+    bool readTick(std::vector<InputEvent>& inputs, uint64_t& stateHash);
+
+    // Restores the nearest keyframe at or before the tick and simulates the rest of the way, leaving the game as it
+    // was just before that tick ran. The next readTick returns that tick.
+    bool seek(uint64_t tick, GameState& gameState);
+
+private:
+    bool readFooter();
+    bool scanKeyframes();
+    bool readKeyframe(size_t& offset, const uint8_t*& state, uint32_t& size) const;
+    bool readTickAt(size_t& offset, std::vector<InputEvent>& inputs, uint64_t& stateHash) const;
+
+    struct KeyframeEntry
+    {
+        uint64_t tick;
+        uint64_t offset;
+    };
+
+    MappedFile m_file;
+    std::string m_path;
+    uint32_t m_keyframeInterval = 0;
+    uint64_t m_initialStateHash = 0;
+    size_t m_bodyStart = 0;
+    size_t m_bodyEnd = 0; // where the index starts, or the end of an unclosed log
+    uint64_t m_tickCount = 0;
+    std::vector<KeyframeEntry> m_keyframes;
+
+    size_t m_offset = 0;
+    uint64_t m_nextTick = 0;
+};
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <SDL.h>
+
+#include "Profiler.hpp"
+#include "SimulationThread.hpp"
+#include "util.hpp"
+
+SimulationThread::SimulationThread(GameState& gameState, ReplayWriter* recorder)
+: m_gameState(gameState), m_recorder(recorder)
+{
+    // so there is something to draw before the first tick
+    const uint64_t now = m_gameState.getClock().now();
+    publishSnapshot(now, now);
+
+    m_thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread()
+{
+    m_running = false;
+    m_thread.join();
+}
+
+void SimulationThread::pushInput(const InputEvent& input)
+{
+    std::lock_guard<std::mutex> lock(m_inputMutex);
+    m_pendingInput.push_back(input);
+}
+
+const FrameSnapshot& SimulationThread::acquireSnapshot()
+{
+    m_snapshots.acquire();
+    return m_snapshots.getReadBuffer();
+}
+
+void SimulationThread::run()
+{
+    LOG_INFO("Simulation running at %d ticks per second", GameState::TICKS_PER_SECOND);
+    TraceRecorder::setThreadName("simulation");
+
+    const Clock& clock = m_gameState.getClock();
+    uint64_t startTime = clock.now();
+    uint64_t ticksSinceStart = 0;
+
+    while(m_running)
+    {
+        // tick times are computed from the start rather than accumulated, so rounding never drifts
+        const uint64_t tickTime = startTime + getTickOffset(ticksSinceStart);
+        const uint64_t now = clock.now();
+        if(now < tickTime)
+        {
+            // a clock that doesn't follow real time (paused, or only stepped by hand) is polled every millisecond
+            const double rate = clock.getRate();
+            const double waitMs = rate > 0.0 ? (double)(tickTime - now) / rate / 1'000'000.0 : 0.0;
+            SDL_Delay((Uint32)std::max(1.0, waitMs));
+            continue;
+        }
+
+        if(now - tickTime > getTickOffset(MAX_TICK_BACKLOG))
+        {
+            LOG_WARN("Simulation fell behind, skipping ahead");
+            startTime = now;
+            ticksSinceStart = 0;
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_inputMutex);
+            m_tickInput.swap(m_pendingInput);
+        }
+        for(const InputEvent& input : m_tickInput)
+        {
+            m_gameState.handleInput(input);
+        }
+
+        m_gameState.tick();
+        if(m_recorder != nullptr)
+        {
+            m_recorder->writeTick(m_tickInput, m_gameState);
+        }
+        m_tickInput.clear();
+        ticksSinceStart++;
+        publishSnapshot(tickTime, startTime + getTickOffset(ticksSinceStart));
+    }
+}
+
+uint64_t SimulationThread::getTickOffset(uint64_t ticks)
+{
+    return ticks * Clock::NANOSECONDS_PER_SECOND / GameState::TICKS_PER_SECOND;
+}
+
+void SimulationThread::publishSnapshot(uint64_t tickTime, uint64_t nextTickTime)
+{
+    PROFILE_ZONE("publish snapshot");
+    FrameSnapshot& snapshot = m_snapshots.getWriteBuffer();
+    m_gameState.fillSnapshot(snapshot);
+    snapshot.tickTime = tickTime;
+    snapshot.nextTickTime = nextTickTime;
+    m_snapshots.publish();
+}
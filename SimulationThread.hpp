@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameSnapshot.hpp"
+#include "GameState.hpp"
+#include "ReplayLog.hpp"
+#include "TripleBuffer.hpp"
+
+// Runs the game's ticks on their own thread at a fixed rate, so a slow frame or a vsync stall never delays the
+// simulation or input handling. After every tick a snapshot is published through a lock-free triple buffer; the
+// render thread picks up whichever one is newest.
+// Ticks are paced by the game state's clock, so a scaled clock runs the game faster or slower and a paused one stops
+// it.
+//
+// Nothing else may touch the GameState (or the timers) while this is running.
+class SimulationThread
+{
+public:
+    // every tick's input is written to the recorder if there is one
+    SimulationThread(GameState& gameState, ReplayWriter* recorder = nullptr);
+    SimulationThread(SimulationThread&) = delete;
+    SimulationThread& operator=(SimulationThread&) = delete;
+    ~SimulationThread();
+
+    // input is applied at the start of the next tick
+    void pushInput(const InputEvent& input);
+
+    // the newest published snapshot, which stays valid until the next call
+    const FrameSnapshot& acquireSnapshot();
+
+private:
+    void run();
+    void publishSnapshot(uint64_t tickTime, uint64_t nextTickTime);
+
+    // clock time from one tick to another this many ticks later
+    static uint64_t getTickOffset(uint64_t ticks);
+
+private:
+    // after falling further behind than this (e.g. the process was suspended) ticks restart from now
+    static inline const uint64_t MAX_TICK_BACKLOG = GameState::TICKS_PER_SECOND / 4;
+
+    GameState& m_gameState;
+    ReplayWriter* m_recorder;
+    TripleBuffer<FrameSnapshot> m_snapshots;
+
+    std::mutex m_inputMutex;
+    std::vector<InputEvent> m_pendingInput;
+    std::vector<InputEvent> m_tickInput; // only used by the simulation thread
+
+    std::atomic<bool> m_running {true};
+    std::thread m_thread;
+};
@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <map>
+#include <tuple>
+
+#include "Spans.hpp"
+
+// Covers the same pixels as the original per pixel loops: offsets in (-radius, radius] on both axes.
+template<typename Predicate>
+static std::vector<Span> buildSpans(const int radius, Predicate isInside)
+{
+    std::vector<Span> spans;
+    for(int dy = -radius + 1; dy <= radius; dy++)
+    {
+        int runStart = 0;
+        bool inRun = false;
+        for(int dx = -radius + 1; dx <= radius + 1; dx++)
+        {
+            bool inside = dx <= radius && isInside(dx, dy);
+            if(inside && !inRun)
+            {
+                runStart = dx;
+                inRun = true;
+            }
+            else if(!inside && inRun)
+            {
+                spans.push_back({dy, runStart, dx - runStart});
+                inRun = false;
+            }
+        }
+    }
+    return spans;
+}
+
+const std::vector<Span>& getCircleSpans(const int radius)
+{
+    static std::map<int, std::vector<Span>> cache;
+
+    auto it = cache.find(radius);
+    if(it == cache.end())
+    {
+        it = cache.emplace(radius, buildSpans(radius, [radius](int dx, int dy)
+                                              { return dx * dx + dy * dy <= radius * radius; }))
+                 .first;
+    }
+    return it->second;
+}
+
+const std::vector<Span>& getWedgeSpans(const int radius, const Direction facingDirection, const int mouthPixels)
+{
+    static std::map<std::tuple<int, Direction, int>, std::vector<Span>> cache;
+
+    const auto key = std::make_tuple(radius, facingDirection, mouthPixels);
+    auto it = cache.find(key);
+    if(it == cache.end())
+    {
+        const int xIncrement = X_INCREMENT[(size_t)facingDirection];
+        const int yIncrement = Y_INCREMENT[(size_t)facingDirection];
+        auto isInside = [=](int dx, int dy)
+        {
+            if(dx * dx + dy * dy > radius * radius)
+            {
+                return false;
+            }
+            // the mouth is the part of the circle within a triangle opening in the facing direction
+            return !(
+                (dy * yIncrement >= 0 && dx * xIncrement < mouthPixels && abs(dy) > abs(dx) && yIncrement != 0)
+                || (dx * xIncrement >= 0 && dy * yIncrement < mouthPixels && abs(dx) > abs(dy) && xIncrement != 0));
+        };
+        it = cache.emplace(key, buildSpans(radius, isInside)).first;
+    }
+    return it->second;
+}
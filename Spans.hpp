@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+#include "util.hpp"
+
+// horizontal run of pixels, relative to the center of a shape
+struct Span
+{
+    int dy;
+    int dxStart;
+    int length;
+};
+
+// Span tables are built the first time a shape is requested and cached, so drawing a shape is a few horizontal runs
+// instead of a test per pixel. Any radius is supported, so they keep working if the tile size changes.
+const std::vector<Span>& getCircleSpans(const int radius);
+const std::vector<Span>& getWedgeSpans(const int radius, const Direction facingDirection, const int mouthPixels);
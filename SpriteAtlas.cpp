@@ -0,0 +1,149 @@
+#include <ctype.h>
+#include <algorithm>
+
+#include "SpriteAtlas.hpp"
+#include "GridObject.hpp"
+#include "font.hpp"
+
+SpriteCanvas::SpriteCanvas(int width, int height)
+: m_width(width), m_height(height), m_pixels((size_t)(width * height), 0)
+{
+}
+
+void SpriteCanvas::setPixel(int x, int y, const SDL_Color& color)
+{
+    if(x < 0 || x >= m_width || y < 0 || y >= m_height)
+    {
+        return;
+    }
+    m_pixels[(size_t)(y * m_width + x)] =
+        (uint32_t)color.a << 24 | (uint32_t)color.r << 16 | (uint32_t)color.g << 8 | (uint32_t)color.b;
+}
+
+SpriteAtlas::SpriteAtlas(DrawBatch& batch) : m_batch(batch)
+{
+    m_ghost = addSprite(Ghost::rasterizeSprite(), Ghost::SPRITE_SCALE);
+
+    for(size_t dir = 0; dir < (size_t)Direction::MAX; dir++)
+    {
+        for(int mouthPixels = -Pacman::RADIUS; mouthPixels <= Pacman::RADIUS; mouthPixels++)
+        {
+            m_pacman[dir].push_back(addSprite(Pacman::rasterizeSprite((Direction)dir, mouthPixels), 1));
+        }
+    }
+
+    for(int fruitIndex = 0; fruitIndex < DisplayFruit::getNumSprites(); fruitIndex++)
+    {
+        m_fruit.push_back(addSprite(DisplayFruit::rasterizeSprite(fruitIndex), DisplayFruit::SPRITE_SCALE));
+    }
+
+    for(int glyph = 0; glyph < NUM_GLYPHS; glyph++)
+    {
+        char c = glyph < 10 ? (char)('0' + glyph) : (char)('A' + glyph - 10);
+        m_glyphs[glyph] = addSprite(rasterizeGlyph(c), 1);
+    }
+
+    upload();
+    LOG_INFO("Sprite atlas built: %dx%d", ATLAS_WIDTH, m_packY + m_shelfHeight);
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+    if(m_texture != nullptr)
+    {
+        SDL_DestroyTexture(m_texture);
+    }
+}
+
+SpriteAtlas::Sprite SpriteAtlas::addSprite(const SpriteCanvas& canvas, int scale)
+{
+    // simple shelf packing, sprites are added in rows of similar heights so little space is wasted
+    if(m_packX + canvas.getWidth() > ATLAS_WIDTH)
+    {
+        m_packX = 0;
+        m_packY += m_shelfHeight;
+        m_shelfHeight = 0;
+    }
+
+    SDL_Rect source = {m_packX, m_packY, canvas.getWidth(), canvas.getHeight()};
+    m_packX += canvas.getWidth();
+    m_shelfHeight = std::max(m_shelfHeight, canvas.getHeight());
+
+    m_pending.emplace_back(source, canvas);
+    return {source, scale};
+}
+
+void SpriteAtlas::upload()
+{
+    const int atlasHeight = m_packY + m_shelfHeight;
+    m_pixels.assign((size_t)(ATLAS_WIDTH * atlasHeight), 0);
+    for(const auto& [source, canvas] : m_pending)
+    {
+        for(int row = 0; row < source.h; row++)
+        {
+            const uint32_t* canvasRow = canvas.getPixels() + row * source.w;
+            std::copy(canvasRow, canvasRow + source.w, m_pixels.begin() + (source.y + row) * ATLAS_WIDTH + source.x);
+        }
+    }
+    m_pending.clear();
+
+    m_texture = SDL_CreateTexture(
+        m_batch.getRenderer(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, atlasHeight);
+    LOG_ASSERT(m_texture != nullptr, "Error creating sprite atlas: %s", SDL_GetError());
+    SDL_UpdateTexture(m_texture, nullptr, m_pixels.data(), ATLAS_WIDTH * (int)sizeof(uint32_t));
+    SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+    m_batch.setTexturePixels(m_texture, m_pixels.data(), ATLAS_WIDTH);
+}
+
+void SpriteAtlas::copySprite(const Sprite& sprite, int x, int y, const SDL_Color& tint)
+{
+    SDL_Rect destination = {x, y, sprite.source.w * sprite.scale, sprite.source.h * sprite.scale};
+    m_batch.copy(m_texture, sprite.source, destination, tint);
+}
+
+void SpriteAtlas::drawGhost(const int xCenter, const int yCenter, const SDL_Color& color)
+{
+    const int width = m_ghost.source.w * m_ghost.scale;
+    const int height = m_ghost.source.h * m_ghost.scale;
+    copySprite(m_ghost, xCenter - width / 2, yCenter - height / 2, color);
+}
+
+void SpriteAtlas::drawPacman(
+    const int xCenter, const int yCenter, const Direction facingDirection, const int mouthPixels)
+{
+    int mouthIndex = std::clamp(mouthPixels, -Pacman::RADIUS, Pacman::RADIUS) + Pacman::RADIUS;
+    copySprite(
+        m_pacman[(size_t)facingDirection][mouthIndex],
+        xCenter - Pacman::RADIUS,
+        yCenter - Pacman::RADIUS,
+        COLOR_WHITE);
+}
+
+void SpriteAtlas::drawFruit(const int xCenter, const int yCenter, const int fruitIndex)
+{
+    const Sprite& sprite = m_fruit[std::clamp(fruitIndex, 0, (int)m_fruit.size() - 1)];
+    const int width = sprite.source.w * sprite.scale;
+    const int height = sprite.source.h * sprite.scale;
+    copySprite(sprite, xCenter - width / 2, yCenter - height / 2, COLOR_WHITE);
+}
+
+void SpriteAtlas::drawGlyph(const char c, const int x, const int y, const int scale, const SDL_Color& color)
+{
+    int glyph;
+    if(isdigit(c))
+    {
+        glyph = c - '0';
+    }
+    else if(isalpha(c))
+    {
+        glyph = 10 + toupper(c) - 'A';
+    }
+    else
+    {
+        return;
+    }
+
+    Sprite sprite = m_glyphs[glyph];
+    sprite.scale = scale;
+    copySprite(sprite, x, y, color);
+}
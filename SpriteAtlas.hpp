@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <SDL.h>
+
+#include "DrawBatch.hpp"
+#include "util.hpp"
+
+// CPU side pixel buffer that a single sprite is rasterized into before it is packed into the atlas
+class SpriteCanvas
+{
+public:
+    SpriteCanvas(int width, int height);
+    void setPixel(int x, int y, const SDL_Color& color);
+    int getWidth() const
+    {
+        return m_width;
+    }
+    int getHeight() const
+    {
+        return m_height;
+    }
+    const uint32_t* getPixels() const
+    {
+        return m_pixels.data();
+    }
+
+private:
+    int m_width;
+    int m_height;
+    std::vector<uint32_t> m_pixels; // ARGB8888, fully transparent by default
+};
+
+// All sprites are rasterized once at startup into a single texture, after which each sprite is one textured quad in
+// the frame's draw batch.
+// Single colour sprites (ghost body, glyphs) are stored in white and tinted through the vertex colour.
+class SpriteAtlas
+{
+public:
+    SpriteAtlas(DrawBatch& batch);
+    SpriteAtlas(SpriteAtlas&) = delete;
+    SpriteAtlas& operator=(SpriteAtlas&) = delete;
+    ~SpriteAtlas();
+
+    void drawGhost(const int xCenter, const int yCenter, const SDL_Color& color);
+    void drawPacman(const int xCenter, const int yCenter, const Direction facingDirection, const int mouthPixels);
+    void drawFruit(const int xCenter, const int yCenter, const int fruitIndex);
+    void drawGlyph(const char c, const int x, const int y, const int scale, const SDL_Color& color);
+
+private:
+    struct Sprite
+    {
+        SDL_Rect source;
+        int scale;
+    };
+
+    Sprite addSprite(const SpriteCanvas& canvas, int scale);
+    void upload();
+    void copySprite(const Sprite& sprite, int x, int y, const SDL_Color& tint);
+
+private:
+    static inline const int ATLAS_WIDTH = 1024;
+    static inline const int NUM_GLYPHS = 10 + 26;
+
+    DrawBatch& m_batch;
+    SDL_Texture* m_texture = nullptr;
+    std::vector<uint32_t> m_pixels; // kept so software rendering can blit without reading back the texture
+
+    // packing state, the canvases are only kept until upload
+    std::vector<std::pair<SDL_Rect, SpriteCanvas>> m_pending;
+    int m_packX = 0;
+    int m_packY = 0;
+    int m_shelfHeight = 0;
+
+    Sprite m_ghost;
+    std::array<std::vector<Sprite>, (size_t)Direction::MAX> m_pacman;
+    std::vector<Sprite> m_fruit;
+    std::array<Sprite, NUM_GLYPHS> m_glyphs;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// FNV-1a over simulation state, to tell whether two runs of the game are still in step. Values are hashed as 64 bit
+// integers a byte at a time, so the result doesn't depend on type sizes, padding or byte order.
+class StateHash
+{
+public:
+    template<typename T>
+    void add(T value)
+    {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "only integers and enums can be hashed");
+        uint64_t bits = (uint64_t)value;
+        for(int byte = 0; byte < 8; byte++)
+        {
+            addByte((uint8_t)bits);
+            bits >>= 8;
+        }
+    }
+
+    void addBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for(size_t index = 0; index < size; index++)
+        {
+            addByte(bytes[index]);
+        }
+    }
+
+    uint64_t get() const
+    {
+        return m_hash;
+    }
+
+private:
+    void addByte(uint8_t byte)
+    {
+        m_hash = (m_hash ^ byte) * 0x100000001b3;
+    }
+
+    uint64_t m_hash = 0xcbf29ce484222325;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+// Flat binary encoding of simulation state, for replay keyframes. Values are written little endian at their own
+// size, so a keyframe is only meant to be read back by the same build that wrote it.
+
+class StateWriter
+{
+public:
+    StateWriter(std::vector<uint8_t>& bytes) : m_bytes(bytes) {}
+
+    template<typename T>
+    void write(T value)
+    {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "only integers and enums can be saved");
+        uint64_t bits = (uint64_t)value;
+        for(size_t byte = 0; byte < sizeof(T); byte++)
+        {
+            m_bytes.push_back((uint8_t)bits);
+            bits >>= 8;
+        }
+    }
+
+    void write(bool value)
+    {
+        write((uint8_t)value);
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        m_bytes.insert(m_bytes.end(), bytes, bytes + size);
+    }
+
+private:
+    std::vector<uint8_t>& m_bytes;
+};
+
+// Reading past the end doesn't crash, it returns zeros and marks the reader as failed
+class StateReader
+{
+public:
+    StateReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    template<typename T>
+    void read(T& value)
+    {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "only integers and enums can be restored");
+        uint64_t bits = 0;
+        if(m_offset + sizeof(T) > m_size)
+        {
+            m_failed = true;
+        }
+        else
+        {
+            for(size_t byte = 0; byte < sizeof(T); byte++)
+            {
+                bits |= (uint64_t)m_data[m_offset++] << (8 * byte);
+            }
+        }
+        value = (T)bits;
+    }
+
+    void read(bool& value)
+    {
+        uint8_t byte = 0;
+        read(byte);
+        value = byte != 0;
+    }
+
+    void readBytes(void* data, size_t size)
+    {
+        if(m_offset + size > m_size)
+        {
+            m_failed = true;
+            memset(data, 0, size);
+            return;
+        }
+        memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+    }
+
+    bool failed() const
+    {
+        return m_failed;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
@@ -0,0 +1,86 @@
+#include "TextCache.hpp"
+#include "font.hpp"
+#include "util.hpp"
+
+TextCache::TextCache(DrawBatch& batch, SpriteAtlas& atlas) : m_batch(batch), m_atlas(atlas)
+{
+}
+
+TextCache::~TextCache()
+{
+    for(auto& entry : m_entries)
+    {
+        destroyEntry(entry);
+    }
+}
+
+void TextCache::draw(const int x, const int y, const std::string& str, const SDL_Color& color, const int scale)
+{
+    if(str.empty())
+    {
+        return;
+    }
+
+    const Key key(str, (uint32_t)color.a << 24 | (uint32_t)color.r << 16 | (uint32_t)color.g << 8 | color.b, scale);
+    auto it = m_index.find(key);
+    if(it != m_index.end())
+    {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+    }
+    else
+    {
+        if(m_entries.size() == MAX_ENTRIES)
+        {
+            LOG_DEBUG("Evicting cached text \"%s\"", std::get<0>(m_entries.back().key).c_str());
+            destroyEntry(m_entries.back());
+            m_index.erase(m_entries.back().key);
+            m_entries.pop_back();
+        }
+        m_entries.push_front(createEntry(key, str, color, scale));
+        m_index[key] = m_entries.begin();
+    }
+
+    const Entry& entry = m_entries.front();
+    if(entry.texture == nullptr)
+    {
+        drawStringGlyphs(m_atlas, x, y, str, color, scale);
+        return;
+    }
+
+    const SDL_Rect source = {0, 0, entry.width, entry.height};
+    const SDL_Rect destination = {x, y, entry.width, entry.height};
+    m_batch.copy(entry.texture, source, destination, COLOR_WHITE);
+}
+
+TextCache::Entry TextCache::createEntry(const Key& key, const std::string& str, const SDL_Color& color, int scale)
+{
+    SpriteCanvas canvas = rasterizeString(str, color, scale);
+
+    Entry entry;
+    entry.key = key;
+    entry.width = canvas.getWidth();
+    entry.height = canvas.getHeight();
+    entry.pixels.assign(canvas.getPixels(), canvas.getPixels() + entry.width * entry.height);
+
+    entry.texture = SDL_CreateTexture(
+        m_batch.getRenderer(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, entry.width, entry.height);
+    if(entry.texture == nullptr)
+    {
+        LOG_WARN("Error creating text texture, drawing \"%s\" from glyphs: %s", str.c_str(), SDL_GetError());
+        return entry;
+    }
+    SDL_UpdateTexture(entry.texture, nullptr, entry.pixels.data(), entry.width * (int)sizeof(uint32_t));
+    SDL_SetTextureBlendMode(entry.texture, SDL_BLENDMODE_BLEND);
+    m_batch.setTexturePixels(entry.texture, entry.pixels.data(), entry.width);
+    return entry;
+}
+
+void TextCache::destroyEntry(Entry& entry)
+{
+    if(entry.texture != nullptr)
+    {
+        m_batch.removeTexturePixels(entry.texture);
+        SDL_DestroyTexture(entry.texture);
+        entry.texture = nullptr;
+    }
+}
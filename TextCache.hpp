@@ -0,0 +1,52 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <SDL.h>
+
+#include "DrawBatch.hpp"
+#include "SpriteAtlas.hpp"
+
+// Whole strings rendered once into their own texture and reused until they are no longer drawn, so HUD text is a
+// single copy per string instead of one per glyph. The least recently used string is evicted when the cache is full.
+// If a texture can't be created the text is drawn glyph by glyph from the atlas instead.
+class TextCache
+{
+public:
+    TextCache(DrawBatch& batch, SpriteAtlas& atlas);
+    TextCache(TextCache&) = delete;
+    TextCache& operator=(TextCache&) = delete;
+    ~TextCache();
+
+    // (x, y) is the top left corner of the first character
+    void draw(int x, int y, const std::string& str, const SDL_Color& color, int scale);
+
+private:
+    using Key = std::tuple<std::string, uint32_t, int>;
+
+    struct Entry
+    {
+        Key key;
+        SDL_Texture* texture;
+        int width;
+        int height;
+        std::vector<uint32_t> pixels; // kept so software rendering can blit without reading back the texture
+    };
+
+    Entry createEntry(const Key& key, const std::string& str, const SDL_Color& color, int scale);
+    void destroyEntry(Entry& entry);
+
+private:
+    // must stay above the number of distinct strings drawn in one frame, since an evicted texture may still be queued
+    static inline const size_t MAX_ENTRIES = 32;
+
+    DrawBatch& m_batch;
+    SpriteAtlas& m_atlas;
+
+    // most recently used at the front
+    std::list<Entry> m_entries;
+    std::map<Key, std::list<Entry>::iterator> m_index;
+};
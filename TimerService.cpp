@@ -1,59 +1,573 @@
+#include <algorithm>
+
 #include "TimerService.hpp"
+#include "Profiler.hpp"
+#include "util.hpp"
 
-TimerService& TimerService::getInstance()
+TimerHandle TimerService::addTimer(uint64_t duration, bool autoRestart, TimerCallback callback, const TimerGroup* group)
 {
-    static TimerService instance;
-    return instance;
-}
+    uint32_t index = 0;
+    if(!m_freeTimers.empty())
+    {
+        index = m_freeTimers.back();
+        m_freeTimers.pop_back();
+    }
+    else
+    {
+        // the last index is left out so no key can ever equal NO_TIMER
+        LOG_ASSERT(m_timers.size() < INDEX_MASK, "Too many timers, %zu", m_timers.size());
+        index = (uint32_t)m_timers.size();
+        m_timers.emplace_back();
+    }
 
-size_t TimerService::addTimer(uint64_t duration, bool autoRestart, std::function<void()> callback)
-{
-    size_t addKey = nextKey;
-    ++nextKey;
-    m_timers.insert({addKey, Timer(duration, autoRestart, callback)});
-    return addKey;
+    Timer& timer = m_timers[index];
+    timer.callback = callback;
+    timer.duration = duration;
+    timer.autoRestart = autoRestart;
+    timer.isRunning = false;
+    timer.inUse = true;
+    addToGroup(index, group);
+
+    m_stats.added++;
+    m_stats.live++;
+    m_stats.peak = std::max(m_stats.peak, m_stats.live);
+#ifndef NDEBUG
+    LOG_ASSERT(m_stats.live <= MAX_EXPECTED_TIMERS, "%zu timers live, some must be leaking", m_stats.live);
+#endif
+    return TimerHandle(this, getKey(index));
 }
 
-void TimerService::startTimer(size_t key, uint64_t currentTicks)
+bool TimerService::startTimer(size_t key)
 {
-    auto& timer = m_timers.at(key);
-    timer.deadline = currentTicks + timer.duration;
-    timer.isRunning = true;
+    Timer* timer = findTimer(key);
+    if(timer == nullptr)
+    {
+        LOG_DEBUG("Ignoring start of stale timer %zx", key);
+        return false;
+    }
+
+    timer->deadline = m_currentTicks + timer->duration;
+    timer->startOrder = m_nextStartOrder++;
+    const uint32_t index = (uint32_t)(key & INDEX_MASK);
+    if(timer->isRunning)
+    {
+        // the new deadline may be earlier or later than the old one
+        eraseHeap(index);
+    }
+    timer->isRunning = true;
+    pushHeap(index);
+    return true;
 }
 
-void TimerService::pauseTimer(size_t key, uint64_t currentTicks)
+bool TimerService::pauseTimer(size_t key)
 {
-    auto& timer = m_timers.at(key);
-    timer.duration = timer.deadline - currentTicks;
-    timer.isRunning = false;
+    Timer* timer = findTimer(key);
+    if(timer == nullptr)
+    {
+        LOG_DEBUG("Ignoring pause of stale timer %zx", key);
+        return false;
+    }
+
+    // pausing twice keeps what was left the first time
+    if(timer->isRunning)
+    {
+        timer->duration = timer->deadline - m_currentTicks;
+        timer->isRunning = false;
+        eraseHeap((uint32_t)(key & INDEX_MASK));
+    }
+    return true;
 }
 
 void TimerService::stopTimer(size_t key)
 {
-    // erase has no effect if the key does not exist
-    m_timers.erase(key);
+    // has no effect if the timer is already gone
+    if(findTimer(key) != nullptr)
+    {
+        removeTimer((uint32_t)(key & INDEX_MASK));
+        m_stats.stopped++;
+    }
 }
 
 void TimerService::checkTimers(uint64_t currentTicks)
 {
-    for(auto it = m_timers.begin(); it != m_timers.end();)
+    m_currentTicks = currentTicks;
+
+    // timers (re)started by the callbacks wait for the next check, even with no duration
+    const uint64_t checkStartOrder = m_nextStartOrder;
+    while(!m_heap.empty())
     {
-        auto& [key, timer] = *it;
+        const uint32_t index = m_heap.front();
+        Timer& timer = m_timers[index];
+        if(timer.deadline > currentTicks || timer.startOrder >= checkStartOrder)
+        {
+            break;
+        }
+
+        const size_t key = getKey(index);
+        eraseHeap(index);
+        timer.isRunning = false;
 
-        if(timer.isRunning && currentTicks >= timer.deadline)
         {
-            timer.callback();
-            if(timer.autoRestart)
+            // copied, the callback may add timers and move this one
+            TimerCallback callback = timer.callback;
+            PROFILE_ZONE_ARG("timer callback", (int64_t)key);
+            callback();
+        }
+
+        // unless the callback stopped or restarted it
+        Timer* firedTimer = findTimer(key);
+        if(firedTimer != nullptr && !firedTimer->isRunning)
+        {
+            if(firedTimer->autoRestart)
             {
-                startTimer(key, currentTicks);
+                startTimer(key);
             }
             else
             {
-                // erase invalidates the previous iterators, so get a new one
-                it = m_timers.erase(it);
-                continue;
+                removeTimer(index);
+                m_stats.expired++;
             }
         }
-        it++;
     }
 }
+
+std::optional<uint64_t> TimerService::getNextDeadline() const
+{
+    if(m_heap.empty())
+    {
+        return std::nullopt;
+    }
+    return m_timers[m_heap.front()].deadline;
+}
+
+void TimerService::hashState(StateHash& hash) const
+{
+    // the slot order isn't part of the state, so the timers' hashes are summed rather than chained
+    uint64_t timersHash = 0;
+    size_t timerCount = 0;
+    for(uint32_t index = 0; index < m_timers.size(); index++)
+    {
+        const Timer& timer = m_timers[index];
+        if(!timer.inUse)
+        {
+            continue;
+        }
+        StateHash timerHash;
+        timerHash.add(getKey(index));
+        timerHash.add(timer.deadline);
+        timerHash.add(timer.duration);
+        timerHash.add(timer.startOrder);
+        timerHash.add(timer.autoRestart);
+        timerHash.add(timer.isRunning);
+        timersHash += timerHash.get();
+        timerCount++;
+    }
+    hash.add(m_currentTicks);
+    hash.add(m_nextStartOrder);
+    hash.add(timerCount);
+    hash.add(timersHash);
+}
+
+void TimerService::saveState(StateWriter& writer) const
+{
+    writer.write(m_currentTicks);
+    writer.write(m_nextStartOrder);
+
+    // generations and the free list decide which keys are handed out next
+    writer.write((uint32_t)m_timers.size());
+    for(const Timer& timer : m_timers)
+    {
+        writer.write((uint64_t)timer.generation);
+    }
+    writer.write((uint32_t)m_freeTimers.size());
+    for(const uint32_t index : m_freeTimers)
+    {
+        writer.write(index);
+    }
+}
+
+void TimerService::restoreState(StateReader& reader)
+{
+    reader.read(m_currentTicks);
+    reader.read(m_nextStartOrder);
+
+    uint32_t timerCount = 0;
+    reader.read(timerCount);
+    m_timers.assign(std::min<size_t>(timerCount, INDEX_MASK), Timer());
+    for(Timer& timer : m_timers)
+    {
+        uint64_t generation = 0;
+        reader.read(generation);
+        timer.generation = (size_t)generation;
+    }
+
+    uint32_t freeCount = 0;
+    reader.read(freeCount);
+    m_freeTimers.clear();
+    m_stats.live = 0;
+    for(uint32_t free = 0; free < freeCount && !reader.failed(); free++)
+    {
+        uint32_t index = 0;
+        reader.read(index);
+        if(index < m_timers.size())
+        {
+            m_freeTimers.push_back(index);
+        }
+    }
+    m_heap.clear();
+    for(Group& group : m_groups)
+    {
+        group.firstTimer = NOT_IN_GROUP;
+    }
+}
+
+void TimerService::saveTimer(StateWriter& writer, size_t key) const
+{
+    // owners keep the keys of timers that have since expired, those are saved as absent
+    const Timer* timer = findTimer(key);
+    writer.write(timer != nullptr);
+    if(timer != nullptr)
+    {
+        writer.write(timer->deadline);
+        writer.write(timer->duration);
+        writer.write(timer->startOrder);
+        writer.write(timer->autoRestart);
+        writer.write(timer->isRunning);
+    }
+}
+
+void TimerService::restoreTimer(StateReader& reader, size_t key, TimerCallback callback, const TimerGroup* group)
+{
+    bool present = false;
+    reader.read(present);
+    if(!present)
+    {
+        return;
+    }
+
+    Timer restored;
+    restored.callback = callback;
+    restored.generation = key >> INDEX_BITS;
+    restored.inUse = true;
+    reader.read(restored.deadline);
+    reader.read(restored.duration);
+    reader.read(restored.startOrder);
+    reader.read(restored.autoRestart);
+    reader.read(restored.isRunning);
+
+    const uint32_t index = (uint32_t)(key & INDEX_MASK);
+    if(reader.failed() || index >= m_timers.size() || m_timers[index].generation != restored.generation)
+    {
+        LOG_ERROR("Saved timer %zx doesn't match the saved timer slots", key);
+        return;
+    }
+    if(m_timers[index].inUse)
+    {
+        LOG_ERROR("Timer %zx was restored twice", key);
+        return;
+    }
+    m_timers[index] = restored;
+    if(restored.isRunning)
+    {
+        pushHeap(index);
+    }
+    addToGroup(index, group);
+    m_stats.live++;
+    m_stats.peak = std::max(m_stats.peak, m_stats.live);
+}
+
+TimerService::Timer* TimerService::findTimer(size_t key)
+{
+    const size_t index = key & INDEX_MASK;
+    if(key == NO_TIMER || index >= m_timers.size())
+    {
+        return nullptr;
+    }
+    Timer& timer = m_timers[index];
+    return timer.inUse && timer.generation == key >> INDEX_BITS ? &timer : nullptr;
+}
+
+const TimerService::Timer* TimerService::findTimer(size_t key) const
+{
+    return const_cast<TimerService*>(this)->findTimer(key);
+}
+
+void TimerService::removeTimer(uint32_t index)
+{
+    Timer& timer = m_timers[index];
+    if(timer.heapIndex != NOT_IN_HEAP)
+    {
+        eraseHeap(index);
+    }
+    if(timer.group != NO_GROUP)
+    {
+        // unlink from the group's list
+        if(timer.previousInGroup != NOT_IN_GROUP)
+        {
+            m_timers[timer.previousInGroup].nextInGroup = timer.nextInGroup;
+        }
+        else
+        {
+            m_groups[timer.group].firstTimer = timer.nextInGroup;
+        }
+        if(timer.nextInGroup != NOT_IN_GROUP)
+        {
+            m_timers[timer.nextInGroup].previousInGroup = timer.previousInGroup;
+        }
+        timer.group = NO_GROUP;
+        timer.previousInGroup = NOT_IN_GROUP;
+        timer.nextInGroup = NOT_IN_GROUP;
+    }
+    timer.callback = TimerCallback();
+    timer.isRunning = false;
+    timer.inUse = false;
+    timer.generation = (timer.generation + 1) & (SIZE_MAX >> INDEX_BITS);
+    m_freeTimers.push_back(index);
+    m_stats.live--;
+}
+
+void TimerService::addToGroup(uint32_t index, const TimerGroup* group)
+{
+    if(group == nullptr)
+    {
+        return;
+    }
+    Timer& timer = m_timers[index];
+    Group& timerGroup = m_groups[group->m_id];
+    timer.group = group->m_id;
+    timer.previousInGroup = NOT_IN_GROUP;
+    timer.nextInGroup = timerGroup.firstTimer;
+    if(timerGroup.firstTimer != NOT_IN_GROUP)
+    {
+        m_timers[timerGroup.firstTimer].previousInGroup = index;
+    }
+    timerGroup.firstTimer = index;
+}
+
+uint32_t TimerService::createGroup(const TimerGroup* parent)
+{
+    uint32_t id = 0;
+    if(!m_freeGroups.empty())
+    {
+        id = m_freeGroups.back();
+        m_freeGroups.pop_back();
+    }
+    else
+    {
+        id = (uint32_t)m_groups.size();
+        m_groups.emplace_back();
+    }
+    m_groups[id] = Group();
+    m_groups[id].parent = parent != nullptr ? parent->m_id : NO_GROUP;
+    m_groups[id].inUse = true;
+    return id;
+}
+
+void TimerService::stopGroup(uint32_t group)
+{
+    while(m_groups[group].firstTimer != NOT_IN_GROUP)
+    {
+        removeTimer(m_groups[group].firstTimer);
+        m_stats.stopped++;
+    }
+    // there are only ever a handful of groups, so the children are found by looking through all of them
+    for(uint32_t child = 0; child < m_groups.size(); child++)
+    {
+        if(m_groups[child].inUse && m_groups[child].parent == group)
+        {
+            stopGroup(child);
+        }
+    }
+}
+
+void TimerService::releaseGroup(uint32_t group)
+{
+    stopGroup(group);
+    for(Group& child : m_groups)
+    {
+        if(child.parent == group)
+        {
+            child.parent = NO_GROUP;
+        }
+    }
+    m_groups[group].inUse = false;
+    m_freeGroups.push_back(group);
+}
+
+bool TimerService::isEarlier(uint32_t a, uint32_t b) const
+{
+    const Timer& timerA = m_timers[a];
+    const Timer& timerB = m_timers[b];
+    return timerA.deadline != timerB.deadline ? timerA.deadline < timerB.deadline
+                                              : timerA.startOrder < timerB.startOrder;
+}
+
+void TimerService::pushHeap(uint32_t index)
+{
+    m_heap.push_back(index);
+    m_timers[index].heapIndex = (uint32_t)m_heap.size() - 1;
+    siftUp((uint32_t)m_heap.size() - 1);
+}
+
+void TimerService::eraseHeap(uint32_t index)
+{
+    const uint32_t position = m_timers[index].heapIndex;
+    m_timers[index].heapIndex = NOT_IN_HEAP;
+    const uint32_t last = m_heap.back();
+    m_heap.pop_back();
+    if(position == m_heap.size())
+    {
+        return;
+    }
+
+    // the last entry fills the hole, then moves whichever way it's out of order
+    placeInHeap(position, last);
+    siftUp(position);
+    siftDown(m_timers[last].heapIndex);
+}
+
+void TimerService::siftUp(uint32_t position)
+{
+    const uint32_t index = m_heap[position];
+    while(position > 0)
+    {
+        const uint32_t parent = (position - 1) / 2;
+        if(!isEarlier(index, m_heap[parent]))
+        {
+            break;
+        }
+        placeInHeap(position, m_heap[parent]);
+        position = parent;
+    }
+    placeInHeap(position, index);
+}
+
+void TimerService::siftDown(uint32_t position)
+{
+    const uint32_t index = m_heap[position];
+    const uint32_t size = (uint32_t)m_heap.size();
+    while(true)
+    {
+        uint32_t child = position * 2 + 1;
+        if(child >= size)
+        {
+            break;
+        }
+        if(child + 1 < size && isEarlier(m_heap[child + 1], m_heap[child]))
+        {
+            child++;
+        }
+        if(!isEarlier(m_heap[child], index))
+        {
+            break;
+        }
+        placeInHeap(position, m_heap[child]);
+        position = child;
+    }
+    placeInHeap(position, index);
+}
+
+void TimerService::placeInHeap(uint32_t position, uint32_t index)
+{
+    m_heap[position] = index;
+    m_timers[index].heapIndex = position;
+}
+
+TimerHandle::TimerHandle(TimerHandle&& other)
+: m_timerService(other.m_timerService), m_key(std::exchange(other.m_key, TimerService::NO_TIMER))
+{
+}
+
+TimerHandle& TimerHandle::operator=(TimerHandle&& other)
+{
+    if(this != &other)
+    {
+        stop();
+        m_timerService = other.m_timerService;
+        m_key = std::exchange(other.m_key, TimerService::NO_TIMER);
+    }
+    return *this;
+}
+
+TimerHandle::~TimerHandle()
+{
+    stop();
+}
+
+bool TimerHandle::start()
+{
+    return m_timerService != nullptr && m_timerService->startTimer(m_key);
+}
+
+bool TimerHandle::pause()
+{
+    return m_timerService != nullptr && m_timerService->pauseTimer(m_key);
+}
+
+void TimerHandle::stop()
+{
+    if(m_timerService != nullptr)
+    {
+        m_timerService->stopTimer(m_key);
+    }
+    m_key = TimerService::NO_TIMER;
+}
+
+bool TimerHandle::isActive() const
+{
+    return m_timerService != nullptr && m_timerService->findTimer(m_key) != nullptr;
+}
+
+size_t TimerHandle::release()
+{
+    return std::exchange(m_key, TimerService::NO_TIMER);
+}
+
+void TimerHandle::save(StateWriter& writer) const
+{
+    writer.write((uint64_t)m_key);
+    if(m_timerService != nullptr)
+    {
+        m_timerService->saveTimer(writer, m_key);
+    }
+    else
+    {
+        writer.write(false);
+    }
+}
+
+void TimerHandle::restore(
+    StateReader& reader,
+    TimerService& timerService,
+    TimerCallback callback,
+    const TimerGroup* group)
+{
+    uint64_t savedKey = 0;
+    reader.read(savedKey);
+    m_timerService = &timerService;
+    m_key = (size_t)savedKey;
+    timerService.restoreTimer(reader, m_key, callback, group);
+}
+
+TimerGroup::TimerGroup(TimerService& timerService, const TimerGroup* parent)
+: m_timerService(&timerService), m_id(timerService.createGroup(parent))
+{
+}
+
+TimerGroup::TimerGroup(TimerGroup&& other)
+: m_timerService(std::exchange(other.m_timerService, nullptr)), m_id(other.m_id)
+{
+}
+
+TimerGroup::~TimerGroup()
+{
+    if(m_timerService != nullptr)
+    {
+        m_timerService->releaseGroup(m_id);
+    }
+}
+
+void TimerGroup::stopAll()
+{
+    m_timerService->stopGroup(m_id);
+}
@@ -1,39 +1,243 @@
 #pragma once
 
-#include <functional>
-#include <unordered_map>
+#include <stdint.h>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <SDL.h>
 
-class TimerService
+#include "StateHash.hpp"
+#include "StateSerializer.hpp"
+
+// A callback stored inside the timer, so adding a timer never allocates. Anything callable that is small and trivially
+// copyable fits, which covers lambdas capturing this or a few values.
+class TimerCallback
 {
 public:
-    static TimerService& getInstance();
-    size_t addTimer(uint64_t duration, bool autoRestart, std::function<void()> callback);
-    void startTimer(size_t key, uint64_t currentTicks = SDL_GetTicks64());
-    void pauseTimer(size_t key, uint64_t currentTicks = SDL_GetTicks64());
-    void stopTimer(size_t key);
-    void checkTimers(uint64_t currentTicks = SDL_GetTicks64());
+    static inline const size_t CAPACITY = 3 * sizeof(void*);
 
-private:
-    struct Timer
+    TimerCallback() = default;
+
+    template<typename Function>
+    TimerCallback(Function function)
     {
-        uint64_t deadline = 0;
-        uint64_t duration;
-        std::function<void()> callback;
-        bool autoRestart;
-        bool isRunning = false;
+        static_assert(sizeof(Function) <= CAPACITY, "Timer callback captures too much to be stored inline");
+        static_assert(alignof(Function) <= alignof(void*), "Timer callback is over-aligned");
+        static_assert(std::is_trivially_copyable_v<Function>, "Timer callback must be trivially copyable");
+        new(m_storage) Function(function);
+        m_invoke = [](void* storage) { (*std::launder(reinterpret_cast<Function*>(storage)))(); };
+    }
+
+    void operator()()
+    {
+        m_invoke(m_storage);
+    }
+
+private:
+    alignas(void*) unsigned char m_storage[CAPACITY];
+    void (*m_invoke)(void*) = nullptr;
+};
+
+class TimerGroup;
+class TimerHandle;
+
+// Times are milliseconds of simulation time, which only moves forward when the game calls checkTimers each tick.
+// Timers started or paused in between use the time of the last check.
+//
+// Running timers are kept in a min-heap on their deadline, so a check only looks at the timers that are due and the
+// next deadline is always at the top. Keys carry a generation as well as a slot, and a slot's generation changes
+// whenever its timer goes away, so a key kept after its timer expired or was stopped is recognised as stale rather
+// than picking up whichever timer reuses the slot.
+//
+// Timers are owned through a TimerHandle, which stops its timer when it goes away or is replaced, and can be put in a
+// TimerGroup to be stopped together with the rest of the group.
+//
+// Each game owns its own service and nothing is shared between services, so any number of games can run side by side.
+// A service doesn't lock, it and everything holding its timers must only be used by one thread at a time.
+class TimerService
+{
+public:
+    // a key that never refers to a timer, stopping it does nothing
+    static inline const size_t NO_TIMER = SIZE_MAX;
 
-        Timer(uint64_t duration, bool autoRestart, std::function<void()>& callback)
-        : duration(duration), autoRestart(autoRestart), callback(callback)
-        {
-        }
+    // more live timers than the game could ever need at once, debug builds stop here as one must be leaking
+    static inline const size_t MAX_EXPECTED_TIMERS = 1024;
+
+    struct Stats
+    {
+        size_t live = 0;
+        size_t peak = 0;
+        uint64_t added = 0;
+        uint64_t expired = 0;
+        uint64_t stopped = 0;
     };
-    std::unordered_map<size_t, Timer> m_timers;
-    size_t nextKey = 0;
 
     TimerService() = default;
     TimerService(TimerService&) = delete;
     TimerService(TimerService&&) = delete;
     TimerService& operator=(TimerService&) = delete;
     TimerService& operator=(TimerService&&) = delete;
-};
\ No newline at end of file
+
+    TimerHandle addTimer(
+        uint64_t duration,
+        bool autoRestart,
+        TimerCallback callback,
+        const TimerGroup* group = nullptr);
+
+    // starting restarts the full duration, or what was left when paused; both are ignored for stale keys
+    bool startTimer(size_t key);
+    bool pauseTimer(size_t key);
+    void stopTimer(size_t key);
+    void checkTimers(uint64_t currentTicks);
+
+    // earliest deadline of the running timers, if any are running
+    std::optional<uint64_t> getNextDeadline() const;
+
+    void hashState(StateHash& hash) const;
+
+    // For replay keyframes. Callbacks can't be saved, so restoreState drops every timer and each owner then restores
+    // its own with restoreTimer, passing the callback again. Keys, deadlines and the keys handed out next are kept
+    // exactly.
+    void saveState(StateWriter& writer) const;
+    void restoreState(StateReader& reader);
+    void saveTimer(StateWriter& writer, size_t key) const;
+    void restoreTimer(StateReader& reader, size_t key, TimerCallback callback, const TimerGroup* group = nullptr);
+
+    const Stats& getStats() const
+    {
+        return m_stats;
+    }
+
+private:
+    static inline const int INDEX_BITS = 20;
+    static inline const size_t INDEX_MASK = ((size_t)1 << INDEX_BITS) - 1;
+    static inline const uint32_t NOT_IN_HEAP = UINT32_MAX;
+    static inline const uint32_t NO_GROUP = UINT32_MAX;
+    static inline const uint32_t NOT_IN_GROUP = UINT32_MAX;
+
+    struct Group
+    {
+        uint32_t parent = NO_GROUP;
+        uint32_t firstTimer = NOT_IN_GROUP;
+        bool inUse = false;
+    };
+
+    struct Timer
+    {
+        TimerCallback callback;
+        uint64_t deadline = 0;
+        uint64_t duration = 0;
+        uint64_t startOrder = 0; // breaks ties between equal deadlines, so they always fire in the same order
+        size_t generation = 0;
+        uint32_t heapIndex = NOT_IN_HEAP;
+        uint32_t group = NO_GROUP;
+        uint32_t previousInGroup = NOT_IN_GROUP;
+        uint32_t nextInGroup = NOT_IN_GROUP;
+        bool autoRestart = false;
+        bool isRunning = false;
+        bool inUse = false;
+    };
+
+    Timer* findTimer(size_t key);
+    const Timer* findTimer(size_t key) const;
+    size_t getKey(uint32_t index) const
+    {
+        return (m_timers[index].generation << INDEX_BITS) | index;
+    }
+    void removeTimer(uint32_t index);
+    void addToGroup(uint32_t index, const TimerGroup* group);
+
+    uint32_t createGroup(const TimerGroup* parent);
+    void stopGroup(uint32_t group);
+    void releaseGroup(uint32_t group);
+
+    // heap of indices into m_timers, ordered by deadline then start order
+    bool isEarlier(uint32_t a, uint32_t b) const;
+    void pushHeap(uint32_t index);
+    void eraseHeap(uint32_t index);
+    void siftUp(uint32_t position);
+    void siftDown(uint32_t position);
+    void placeInHeap(uint32_t position, uint32_t index);
+
+    std::vector<Timer> m_timers;
+    std::vector<uint32_t> m_freeTimers; // reused last in, first out
+    std::vector<uint32_t> m_heap;
+    uint64_t m_nextStartOrder = 0;
+    uint64_t m_currentTicks = 0;
+
+    // groups aren't part of the saved state, their owners put restored timers back in them
+    std::vector<Group> m_groups;
+    std::vector<uint32_t> m_freeGroups;
+
+    Stats m_stats;
+
+    friend class TimerGroup;
+    friend class TimerHandle;
+};
+
+// Owns one timer and stops it when destroyed or assigned another, so a timer can't outlive the object it calls back
+// into. Whatever happens to the timer, a handle never touches a timer it doesn't own.
+class TimerHandle
+{
+public:
+    TimerHandle() = default;
+    TimerHandle(TimerHandle&& other);
+    TimerHandle& operator=(TimerHandle&& other);
+    TimerHandle(TimerHandle&) = delete;
+    TimerHandle& operator=(TimerHandle&) = delete;
+    ~TimerHandle();
+
+    bool start();
+    bool pause();
+    void stop();
+
+    // still running, paused or waiting to be started, rather than expired or stopped
+    bool isActive() const;
+    size_t getKey() const
+    {
+        return m_key;
+    }
+
+    // gives up ownership, the timer is left to expire or to be stopped through its key or group
+    size_t release();
+
+    // For replay keyframes, the key then the timer. Restoring follows TimerService::restoreState, which has already
+    // dropped the old timer, so unlike assigning it doesn't stop anything.
+    void save(StateWriter& writer) const;
+    void restore(
+        StateReader& reader,
+        TimerService& timerService,
+        TimerCallback callback,
+        const TimerGroup* group = nullptr);
+
+private:
+    TimerHandle(TimerService* timerService, size_t key) : m_timerService(timerService), m_key(key) {}
+
+    TimerService* m_timerService = nullptr;
+    size_t m_key = TimerService::NO_TIMER;
+
+    friend class TimerService;
+};
+
+// Timers added to a group are stopped together by stopAll, or when the group goes away. Stopping a group also stops
+// the groups under it, so a game can own a group per level and per ghost and still stop everything at once.
+class TimerGroup
+{
+public:
+    TimerGroup(TimerService& timerService, const TimerGroup* parent = nullptr);
+    TimerGroup(TimerGroup&& other);
+    TimerGroup(TimerGroup&) = delete;
+    TimerGroup& operator=(TimerGroup&) = delete;
+    TimerGroup& operator=(TimerGroup&&) = delete;
+    ~TimerGroup();
+
+    void stopAll();
+
+private:
+    TimerService* m_timerService;
+    uint32_t m_id;
+
+    friend class TimerService;
+};
@@ -0,0 +1,212 @@
+#include "TraceRecorder.hpp"
+
+#if PACMAN_PROFILER
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <SDL.h>
+
+#include "Profiler.hpp"
+#include "util.hpp"
+
+namespace
+{
+    // a span ('X') carries both its begin and end, so one event per zone and no unmatched pairs when the ring wraps
+    struct TraceEvent
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        int64_t arg;
+        char phase;
+    };
+
+    // Only the owning thread writes the events. It publishes each one by bumping written, and a dump copies the ring
+    // and then checks written again to find out which of the copied slots were overwritten in the meantime.
+    struct ThreadTrace
+    {
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> written {0};
+        const char* name = nullptr;
+        int id = 0;
+    };
+
+    size_t eventsPerThread = 0;
+
+    std::mutex threadMutex;
+    std::vector<std::unique_ptr<ThreadTrace>> threadTraces; // kept after threads exit, for the dump
+    thread_local ThreadTrace* currentThreadTrace = nullptr;
+
+    ThreadTrace& getThreadTrace()
+    {
+        if(currentThreadTrace == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(threadMutex);
+            auto trace = std::make_unique<ThreadTrace>();
+            trace->events.resize(eventsPerThread);
+            trace->id = (int)threadTraces.size() + 1;
+            threadTraces.push_back(std::move(trace));
+            currentThreadTrace = threadTraces.back().get();
+        }
+        return *currentThreadTrace;
+    }
+
+    void addEvent(const TraceEvent& event)
+    {
+        ThreadTrace& trace = getThreadTrace();
+        const uint64_t written = trace.written.load(std::memory_order_relaxed);
+        trace.events[written % trace.events.size()] = event;
+        trace.written.store(written + 1, std::memory_order_release);
+    }
+
+    void writeEscaped(std::ofstream& file, const char* text)
+    {
+        for(; *text != '\0'; text++)
+        {
+            if(*text == '"' || *text == '\\')
+            {
+                file << '\\';
+            }
+            file << *text;
+        }
+    }
+}
+
+void TraceRecorder::start(size_t events)
+{
+    if(recording.load())
+    {
+        return;
+    }
+    // fixed before the first event, every thread's ring gets this size
+    eventsPerThread = std::max<size_t>(events, 1);
+    recording.store(true);
+
+    // most of the spans come from profiler zones
+    Profiler::enable();
+    LOG_INFO("Recording a trace, %zu events per thread", eventsPerThread);
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+    if(isRecording())
+    {
+        getThreadTrace().name = name;
+    }
+}
+
+void TraceRecorder::recordSpan(const char* name, uint64_t start, uint64_t end, int64_t arg)
+{
+    addEvent({name, start, end, arg, 'X'});
+}
+
+void TraceRecorder::recordInstant(const char* name, int64_t arg)
+{
+    const uint64_t now = SDL_GetPerformanceCounter();
+    addEvent({name, now, now, arg, 'i'});
+}
+
+bool TraceRecorder::writeJson(const char* path)
+{
+    if(!isRecording())
+    {
+        LOG_WARN("No trace to write, tracing wasn't started");
+        return false;
+    }
+
+    std::ofstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to write trace %s", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(threadMutex);
+
+    // copy every ring first, so the slow part of the dump doesn't give the other threads time to lap it
+    struct Copy
+    {
+        const ThreadTrace* thread;
+        std::vector<TraceEvent> events;
+    };
+    std::vector<Copy> copies;
+    uint64_t firstTime = UINT64_MAX;
+    for(const auto& thread : threadTraces)
+    {
+        const uint64_t capacity = thread->events.size();
+        const uint64_t written = thread->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > capacity ? written - capacity : 0;
+        Copy copy {thread.get(), {}};
+        copy.events.reserve(written - begin);
+        for(uint64_t index = begin; index < written; index++)
+        {
+            copy.events.push_back(thread->events[index % capacity]);
+        }
+
+        // drop whatever the owner may have reused since the first load, including the slot it may be halfway through
+        const uint64_t reusedEnd = thread->written.load(std::memory_order_acquire) + 1;
+        const uint64_t oldestIntact = reusedEnd > capacity ? reusedEnd - capacity : 0;
+        const uint64_t overwritten = std::min(oldestIntact > begin ? oldestIntact - begin : 0, written - begin);
+        copy.events.erase(copy.events.begin(), copy.events.begin() + overwritten);
+        for(const TraceEvent& event : copy.events)
+        {
+            firstTime = std::min(firstTime, event.start);
+        }
+        copies.push_back(std::move(copy));
+    }
+
+    // timestamps are microseconds from the oldest event kept
+    const double microsecondsPerTick = 1e6 / SDL_GetPerformanceFrequency();
+    const auto toMicroseconds = [&](uint64_t time) { return (double)(time - firstTime) * microsecondsPerTick; };
+
+    size_t eventCount = 0;
+    bool first = true;
+    // fixed, so long traces keep sub-microsecond resolution rather than switching to exponents
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for(const Copy& copy : copies)
+    {
+        if(copy.thread->name != nullptr)
+        {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                 << copy.thread->id << ",\"args\":{\"name\":\"";
+            writeEscaped(file, copy.thread->name);
+            file << "\"}}";
+            first = false;
+        }
+
+        for(const TraceEvent& event : copy.events)
+        {
+            file << (first ? "" : ",\n") << "{\"name\":\"";
+            writeEscaped(file, event.name);
+            file << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << copy.thread->id
+                 << ",\"ts\":" << toMicroseconds(event.start);
+            if(event.phase == 'X')
+            {
+                file << ",\"dur\":" << (double)(event.end - event.start) * microsecondsPerTick;
+            }
+            else
+            {
+                // thread scoped, drawn as a tick on that thread's timeline
+                file << ",\"s\":\"t\"";
+            }
+            if(event.arg != NO_ARG)
+            {
+                file << ",\"args\":{\"value\":" << event.arg << "}";
+            }
+            file << "}";
+            first = false;
+            eventCount++;
+        }
+    }
+    file << "\n]}\n";
+
+    LOG_INFO("Wrote %zu trace events to %s", eventCount, path);
+    return true;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// A timeline of what each thread was doing, for finding the one frame that stalled rather than the averages the
+// profiler reports. Every profiler zone is also recorded as a span here, along with timer callbacks, input and level
+// changes as they happen. Each thread writes into its own ring buffer, allocated once up front, so recording never
+// allocates or locks and only the most recent events are kept. writeJson dumps them in the Chrome trace event format,
+// which chrome://tracing, Perfetto and speedscope can open.
+//
+// Built as part of the profiler, -DPACMAN_PROFILER=OFF compiles it out too.
+
+#if PACMAN_PROFILER
+
+// an instant event on the calling thread's timeline, arg is shown alongside it in the viewer
+#define TRACE_INSTANT(name, arg)                 \
+    if(TraceRecorder::isRecording())             \
+    {                                            \
+        TraceRecorder::recordInstant(name, arg); \
+    }
+
+class TraceRecorder
+{
+public:
+    static inline const size_t DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+    static inline const int64_t NO_ARG = INT64_MIN;
+
+    // nothing is recorded until this is called, events from then on are kept per thread
+    static void start(size_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+    static bool isRecording()
+    {
+        return recording.load(std::memory_order_acquire);
+    }
+
+    // names the calling thread's timeline, the name must outlive the recorder
+    static void setThreadName(const char* name);
+
+    // times are performance counter values, names must be string literals or otherwise outlive the recorder
+    static void recordSpan(const char* name, uint64_t start, uint64_t end, int64_t arg = NO_ARG);
+    static void recordInstant(const char* name, int64_t arg = NO_ARG);
+
+    // can be called while other threads keep recording, events they overwrite during the dump are left out
+    static bool writeJson(const char* path);
+
+private:
+    static inline std::atomic<bool> recording {false};
+};
+
+#else
+
+#define TRACE_INSTANT(name, arg)
+
+class TraceRecorder
+{
+public:
+    static inline const size_t DEFAULT_EVENTS_PER_THREAD = 0;
+
+    static void start(size_t = DEFAULT_EVENTS_PER_THREAD) {}
+    static bool isRecording()
+    {
+        return false;
+    }
+    static void setThreadName(const char*) {}
+    static bool writeJson(const char*)
+    {
+        return false;
+    }
+};
+
+#endif
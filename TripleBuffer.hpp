@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free handoff of the newest value from one writer thread to one reader thread. The writer fills the write
+// buffer and publishes it, the reader acquires whatever was published most recently. Neither side ever waits, and a
+// value the reader holds stays untouched until it acquires again.
+template<typename T>
+class TripleBuffer
+{
+public:
+    // writer side
+    T& getWriteBuffer()
+    {
+        return m_buffers[m_writeIndex];
+    }
+    void publish()
+    {
+        const uint8_t previous = m_middle.exchange(m_writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        m_writeIndex = previous & INDEX_MASK;
+    }
+
+    // reader side, returns false if nothing new was published and the last value is still current
+    bool acquire()
+    {
+        if((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        {
+            return false;
+        }
+        const uint8_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & INDEX_MASK;
+        return true;
+    }
+    const T& getReadBuffer() const
+    {
+        return m_buffers[m_readIndex];
+    }
+
+private:
+    static inline const uint8_t INDEX_MASK = 0x3;
+    static inline const uint8_t FRESH_BIT = 0x4;
+
+    std::array<T, 3> m_buffers;
+    uint8_t m_writeIndex = 0;
+    uint8_t m_readIndex = 1;
+    std::atomic<uint8_t> m_middle {2}; // the buffer between the two sides, flagged when it holds unread data
+};
@@ -0,0 +1,148 @@
+#include <algorithm>
+
+#include "WorkStealingPool.hpp"
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+: m_threadCount(std::max<size_t>(threadCount, 1)), m_queues(new Queue[m_threadCount])
+{
+    // worker 0 is whoever calls run
+    for(size_t worker = 1; worker < m_threadCount; worker++)
+    {
+        m_threads.emplace_back([this, worker]() { workerLoop(worker); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_batchStarted.notify_all();
+    for(std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::run(size_t count, const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(size_t worker = 0; worker < m_threadCount; worker++)
+        {
+            std::lock_guard<std::mutex> queueLock(m_queues[worker].mutex);
+            m_queues[worker].begin = count * worker / m_threadCount;
+            m_queues[worker].end = count * (worker + 1) / m_threadCount;
+        }
+        m_task = &task;
+        m_busyThreads = m_threads.size();
+        m_batch++;
+    }
+    m_batchStarted.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_batchFinished.wait(lock, [this]() { return m_busyThreads == 0; });
+    m_task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(size_t worker)
+{
+    uint64_t lastBatch = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_batchStarted.wait(lock, [&]() { return m_stopping || m_batch != lastBatch; });
+            if(m_stopping)
+            {
+                return;
+            }
+            lastBatch = m_batch;
+        }
+
+        work(worker);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(--m_busyThreads == 0)
+        {
+            m_batchFinished.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::work(size_t worker)
+{
+    // picks where to start looking for work to steal, so idle threads don't all line up on the same victim
+    uint64_t random = 0x9e3779b97f4a7c15ull * (worker + 1);
+
+    // Stolen tasks are in neither queue for a moment, so a thread can give up while another still has some to run.
+    // That only costs the end of the batch a little parallelism, every task still runs exactly once.
+    size_t index = 0;
+    while(true)
+    {
+        if(takeTask(worker, index))
+        {
+            (*m_task)(index, worker);
+        }
+        else if(!steal(worker, random))
+        {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::takeTask(size_t worker, size_t& index)
+{
+    Queue& queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.begin == queue.end)
+    {
+        return false;
+    }
+    index = queue.begin++;
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t worker, uint64_t& random)
+{
+    // xorshift
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+
+    const size_t firstVictim = (size_t)(random % m_threadCount);
+    for(size_t offset = 0; offset < m_threadCount; offset++)
+    {
+        const size_t victim = (firstVictim + offset) % m_threadCount;
+        if(victim == worker)
+        {
+            continue;
+        }
+
+        // the back half, the owner keeps working from the front
+        size_t begin = 0;
+        size_t end = 0;
+        {
+            Queue& queue = m_queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            const size_t remaining = queue.end - queue.begin;
+            if(remaining == 0)
+            {
+                continue;
+            }
+            end = queue.end;
+            queue.end -= (remaining + 1) / 2;
+            begin = queue.end;
+        }
+
+        Queue& queue = m_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = begin;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
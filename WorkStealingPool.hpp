@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a batch of independent tasks, numbered from 0, on a fixed set of threads. Each thread starts with an even,
+// contiguous share of the batch and works through it from the front. A thread that runs out steals the back half of
+// whatever another thread has left, so a few slow tasks don't hold up the batch while other threads sit idle.
+//
+// Each thread's queue has its own lock, touched once per task and once per steal, which is nothing next to a task
+// that simulates a whole game. The thread calling run is one of the workers.
+class WorkStealingPool
+{
+public:
+    // worker is which thread runs the task, from 0 to getThreadCount() - 1, for indexing per thread state
+    using Task = std::function<void(size_t index, size_t worker)>;
+
+    explicit WorkStealingPool(size_t threadCount);
+    WorkStealingPool(WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+
+    size_t getThreadCount() const
+    {
+        return m_threadCount;
+    }
+
+    // returns once task has been run for every index below count, only one batch can run at a time
+    void run(size_t count, const Task& task);
+
+private:
+    // the indices from begin to end, aligned so neighbouring queues don't share a cache line
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void workerLoop(size_t worker);
+    void work(size_t worker);
+    bool takeTask(size_t worker, size_t& index);
+    bool steal(size_t worker, uint64_t& random);
+
+    const size_t m_threadCount;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_batchStarted;
+    std::condition_variable m_batchFinished;
+    const Task* m_task = nullptr;
+    uint64_t m_batch = 0;
+    size_t m_busyThreads = 0;
+    bool m_stopping = false;
+};
@@ -1,3 +1,5 @@
+#include <ctype.h>
+#include <algorithm>
 #include <SDL.h>
 
 #include "font.hpp"
@@ -304,58 +306,104 @@ static const std::vector<bool> FONT_LETTERS =
 };
 // clang-format on
 
-static void displayFromCharset(
-    SDL_Renderer* renderer, const std::vector<bool>& charset, int charIndex, int x, int y, SDL_Color color)
+static SpriteCanvas rasterizeFromCharset(const std::vector<bool>& charset, int charIndex)
 {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SpriteCanvas canvas(FONT_WIDTH_PIXELS, FONT_HEIGHT_PIXELS);
     int bitmapIndex = (FONT_HEIGHT_PIXELS * FONT_WIDTH_PIXELS) * charIndex;
-    for(int lineNumber = 0; lineNumber < FONT_HEIGHT_PIXELS * SCALING_FACTOR; lineNumber += SCALING_FACTOR)
+    for(int lineNumber = 0; lineNumber < FONT_HEIGHT_PIXELS; lineNumber++)
     {
-        for(int pixelNumber = 0; pixelNumber < FONT_WIDTH_PIXELS * SCALING_FACTOR; pixelNumber += SCALING_FACTOR)
+        for(int pixelNumber = 0; pixelNumber < FONT_WIDTH_PIXELS; pixelNumber++)
         {
             if(charset[bitmapIndex])
             {
-                for(int lineScale = 0; lineScale < SCALING_FACTOR; lineScale++)
-                    for(int pixelScale = 0; pixelScale < SCALING_FACTOR; pixelScale++)
-                        SDL_RenderDrawPoint(
-                            renderer, x - (FONT_WIDTH_PIXELS - pixelNumber) + pixelScale, y + lineNumber + lineScale);
+                // glyphs are white so they can be tinted with any text colour when drawn
+                canvas.setPixel(pixelNumber, lineNumber, COLOR_WHITE);
             }
             ++bitmapIndex;
         }
     }
+    return canvas;
 }
 
-void displayNumber(SDL_Renderer* renderer, int x, int y, int number, SDL_Color color)
+SpriteCanvas rasterizeGlyph(char c)
 {
-    int currentRightEdgeX = x;
+    if(isalpha(c))
+    {
+        return rasterizeFromCharset(FONT_LETTERS, toupper(c) - 'A');
+    }
+    return rasterizeFromCharset(FONT_NUMBERS, c - '0');
+}
 
-    for(int remainingValue = number; remainingValue != 0; remainingValue /= 10)
+static int getCharacterAdvance(int scale)
+{
+    return (FONT_WIDTH_PIXELS + 1) * scale;
+}
+
+SpriteCanvas rasterizeString(const std::string& str, const SDL_Color& color, int scale)
+{
+    SpriteCanvas canvas(
+        std::max(1, (int)str.length() * getCharacterAdvance(scale) - scale), FONT_HEIGHT_PIXELS * scale);
+    for(size_t charIndex = 0; charIndex < str.length(); charIndex++)
     {
-        displayFromCharset(renderer, FONT_NUMBERS, remainingValue % 10, currentRightEdgeX, y, color);
-        currentRightEdgeX -= (FONT_WIDTH_PIXELS + 1) * SCALING_FACTOR;
+        if(!isalnum(str[charIndex]))
+        {
+            continue;
+        }
+
+        const SpriteCanvas glyph = rasterizeGlyph(str[charIndex]);
+        const int glyphX = (int)charIndex * getCharacterAdvance(scale);
+        for(int y = 0; y < canvas.getHeight(); y++)
+        {
+            for(int x = 0; x < FONT_WIDTH_PIXELS * scale; x++)
+            {
+                if(glyph.getPixels()[(y / scale) * FONT_WIDTH_PIXELS + x / scale] != 0)
+                {
+                    canvas.setPixel(glyphX + x, y, color);
+                }
+            }
+        }
     }
+    return canvas;
 }
 
-void displayString(SDL_Renderer* renderer, int x, int y, const std::string& str, SDL_Color color)
+void drawStringGlyphs(SpriteAtlas& atlas, int x, int y, const std::string& str, const SDL_Color& color, int scale)
 {
     int currentLeftEdgeX = x;
     for(const char& c : str)
     {
-        if(isalpha(c))
+        if(isalnum(c))
         {
-            displayFromCharset(renderer, FONT_LETTERS, toupper(c) - 'A', currentLeftEdgeX, y, color);
+            atlas.drawGlyph(c, currentLeftEdgeX, y, scale, color);
         }
-        else if(isdigit(c))
-        {
-            displayFromCharset(renderer, FONT_NUMBERS, c - '0', currentLeftEdgeX, y, color);
-        }
-        currentLeftEdgeX += (FONT_WIDTH_PIXELS + 1) * SCALING_FACTOR;
+        currentLeftEdgeX += getCharacterAdvance(scale);
+    }
+}
+
+void displayNumber(TextCache& textCache, int x, int y, int number, SDL_Color color)
+{
+    // x is the right edge of the last digit, and as before nothing is drawn for zero
+    std::string digits;
+    for(int remainingValue = number; remainingValue != 0; remainingValue /= 10)
+    {
+        digits.insert(digits.begin(), (char)('0' + remainingValue % 10));
+    }
+    if(digits.empty())
+    {
+        return;
     }
+
+    const int leftEdgeX = x - ((int)digits.length() - 1) * getCharacterAdvance(SCALING_FACTOR);
+    displayString(textCache, leftEdgeX, y, digits, color);
+}
+
+void displayString(TextCache& textCache, int x, int y, const std::string& str, SDL_Color color)
+{
+    textCache.draw(x - FONT_WIDTH_PIXELS, y, str, color, SCALING_FACTOR);
 }
 
-void autoDisplayString(SDL_Renderer* renderer, const std::string& str, SDL_Color color)
+void autoDisplayString(TextCache& textCache, const std::string& str, SDL_Color color)
 {
     const int x = SCREEN_WIDTH / 2 - (FONT_WIDTH_PIXELS * SCALING_FACTOR * str.length() / 2);
     const int y = 550;
-    displayString(renderer, x, y, str, color);
+    displayString(textCache, x, y, str, color);
 }
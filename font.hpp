@@ -2,9 +2,15 @@
 #include <string>
 #include <vector>
 
-// forward declaration
-struct SDL_Renderer;
+#include "SpriteAtlas.hpp"
+#include "TextCache.hpp"
 
-void displayNumber(SDL_Renderer* renderer, int x, int y, int number, SDL_Color color);
-void displayString(SDL_Renderer* renderer, int x, int y, const std::string& str, SDL_Color color);
-void autoDisplayString(SDL_Renderer* renderer, const std::string& str, SDL_Color color);
\ No newline at end of file
+SpriteCanvas rasterizeGlyph(char c);
+
+// for drawing text with scale and colour, (x, y) is the top left corner and only letters and digits are drawn
+SpriteCanvas rasterizeString(const std::string& str, const SDL_Color& color, int scale);
+void drawStringGlyphs(SpriteAtlas& atlas, int x, int y, const std::string& str, const SDL_Color& color, int scale);
+
+void displayNumber(TextCache& textCache, int x, int y, int number, SDL_Color color);
+void displayString(TextCache& textCache, int x, int y, const std::string& str, SDL_Color color);
+void autoDisplayString(TextCache& textCache, const std::string& str, SDL_Color color);
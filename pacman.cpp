@@ -1,48 +1,244 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <optional>
 #include <SDL.h>
+#include "Clock.hpp"
+#include "FrameScheduler.hpp"
+#include "Framebuffer.hpp"
+#include "GameRenderer.hpp"
 #include "GameState.hpp"
+#include "Profiler.hpp"
+#include "ReplayLog.hpp"
+#include "SimulationThread.hpp"
+
+static const int DEFAULT_TARGET_FPS = 60;
+
+static std::optional<Direction> getKeyDirection(const SDL_Keycode keyCode)
+{
+    switch(keyCode)
+    {
+    case SDLK_UP:
+        return Direction::UP;
+    case SDLK_DOWN:
+        return Direction::DOWN;
+    case SDLK_LEFT:
+        return Direction::LEFT;
+    case SDLK_RIGHT:
+        return Direction::RIGHT;
+    default:
+        return std::nullopt;
+    }
+}
 
 int main(int argc, char** argv)
 {
+    bool incrementalRendering = false;
+    bool softwareRendering = false;
+    bool vsync = false;
+    int targetFps = DEFAULT_TARGET_FPS;
+    double speed = 1.0;
+    const char* recordPath = nullptr;
+    const char* profilePath = nullptr;
+    const char* tracePath = nullptr;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        if(strcmp(argv[arg], "--incremental") == 0)
+        {
+            incrementalRendering = true;
+        }
+        else if(strcmp(argv[arg], "--software") == 0)
+        {
+            softwareRendering = true;
+        }
+        else if(strcmp(argv[arg], "--vsync") == 0)
+        {
+            vsync = true;
+        }
+        else if(strcmp(argv[arg], "--fps") == 0 && arg + 1 < argc)
+        {
+            const char* text = argv[++arg];
+            char* end = nullptr;
+            const long fps = strtol(text, &end, 10);
+            if(end == text || *end != '\0' || fps < 0 || fps > INT_MAX)
+            {
+                LOG_ERROR("--fps takes a whole number 0 or more, not %s", text);
+                return EXIT_FAILURE;
+            }
+            targetFps = (int)fps;
+        }
+        else if(strcmp(argv[arg], "--speed") == 0 && arg + 1 < argc)
+        {
+            const char* text = argv[++arg];
+            char* end = nullptr;
+            speed = strtod(text, &end);
+            if(end == text || *end != '\0' || !isfinite(speed) || speed < 0)
+            {
+                LOG_ERROR("--speed takes a number 0 or more, not %s", text);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[arg], "--record") == 0 && arg + 1 < argc)
+        {
+            recordPath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--profile") == 0 && arg + 1 < argc)
+        {
+            profilePath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc)
+        {
+            tracePath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--log") == 0 && arg + 1 < argc)
+        {
+            if(!Logger::configure(argv[++arg]))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            LOG_WARN("Ignoring unknown argument %s", argv[arg]);
+        }
+    }
+
+    if(vsync)
+    {
+        // the blocking present paces the frames instead
+        targetFps = 0;
+    }
+
+    if(profilePath != nullptr)
+    {
+        Profiler::enable();
+    }
+    if(tracePath != nullptr)
+    {
+        TraceRecorder::start();
+        TraceRecorder::setThreadName("render");
+    }
+
     LOG_ASSERT(SDL_Init(SDL_INIT_EVERYTHING) == 0, "SDL init error: %s", SDL_GetError());
 
     SDL_Window* window = SDL_CreateWindow(
         "Pacman", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
     LOG_ASSERT(window != nullptr, "SDL create window error: %s", SDL_GetError());
 
-    SDL_Surface* screenSurface = SDL_GetWindowSurface(window);
-    SDL_FillRect(screenSurface, NULL, SDL_MapRGB(screenSurface->format, 0xFF, 0xFF, 0xFF));
-    SDL_UpdateWindowSurface(window);
+    std::unique_ptr<Framebuffer> framebuffer;
+    SDL_Renderer* renderer = nullptr;
+    if(softwareRendering)
+    {
+        framebuffer = std::make_unique<Framebuffer>(window, vsync);
+        renderer = framebuffer->getRenderer();
+    }
+    else
+    {
+        SDL_Surface* screenSurface = SDL_GetWindowSurface(window);
+        SDL_FillRect(screenSurface, NULL, SDL_MapRGB(screenSurface->format, 0xFF, 0xFF, 0xFF));
+        SDL_UpdateWindowSurface(window);
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    LOG_ASSERT(renderer != nullptr, "Error creating Renderer: %s", SDL_GetError());
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+        LOG_ASSERT(renderer != nullptr, "Error creating Renderer: %s", SDL_GetError());
+    }
 
     LOG_INFO("SDL started successfully");
 
-    GameState gameState(renderer);
-
-    SDL_Event e;
-    while(true)
     {
-        if(SDL_PollEvent(&e))
+        // scoped so the game's textures are released before the renderer that owns them, and so the simulation
+        // thread stops before the game state it runs is destroyed
+        GameRenderer gameRenderer(renderer, framebuffer.get());
+        gameRenderer.setIncrementalRendering(incrementalRendering);
+        std::unique_ptr<Clock> clock = std::make_unique<RealTimeClock>();
+        if(speed != 1.0)
+        {
+            LOG_INFO("Game clock running at %.2fx", speed);
+            clock = std::make_unique<ScaledClock>(std::move(clock), speed);
+        }
+        GameState gameState(std::move(clock));
+        ReplayWriter recorder;
+        const bool recording = recordPath != nullptr && recorder.open(recordPath, gameState);
+        SimulationThread simulation(gameState, recording ? &recorder : nullptr);
+
+        FrameScheduler scheduler(targetFps);
+        SDL_Event e;
+        bool running = true;
+        while(running)
         {
-            switch(e.type)
+            // sleep until input arrives or the next frame is due, then handle everything that queued up
+            bool hasEvent = scheduler.waitForEvent(e);
+            while(hasEvent)
             {
-            case SDL_QUIT:
-                goto quit;
-            case SDL_KEYDOWN:
-                gameState.handleKeypress((SDL_Keycode)e.key.keysym.sym);
-                break;
-            default:
-                break;
+                switch(e.type)
+                {
+                case SDL_QUIT:
+                    running = false;
+                    break;
+                case SDL_KEYDOWN:
+                case SDL_KEYUP:
+                    if(e.key.keysym.sym == SDLK_F3)
+                    {
+                        if(e.type == SDL_KEYDOWN && !e.key.repeat)
+                        {
+                            gameRenderer.setProfilerOverlay(!gameRenderer.isProfilerOverlayEnabled());
+                        }
+                        break;
+                    }
+                    if(e.key.keysym.sym == SDLK_F4)
+                    {
+                        // dumps what led up to a hitch without quitting, recording carries on
+                        if(e.type == SDL_KEYDOWN && !e.key.repeat && tracePath != nullptr)
+                        {
+                            TraceRecorder::writeJson(tracePath);
+                        }
+                        break;
+                    }
+
+                    // repeats are passed on too, they retry a turn that wasn't possible yet
+                    if(const auto direction = getKeyDirection(e.key.keysym.sym))
+                    {
+                        simulation.pushInput({*direction, e.type == SDL_KEYDOWN});
+                    }
+                    else if(e.type == SDL_KEYDOWN)
+                    {
+                        LOG_WARN("Unsupported keypress %d", e.key.keysym.sym);
+                    }
+                    break;
+                case SDL_RENDER_TARGETS_RESET:
+                    gameRenderer.handleRenderTargetsReset();
+                    break;
+                default:
+                    break;
+                }
+                hasEvent = SDL_PollEvent(&e);
+            }
+
+            if(running && scheduler.isFrameDue())
+            {
+                gameRenderer.render(simulation.acquireSnapshot(), gameState.getClock().now());
+                scheduler.onFrame();
+                Profiler::onFrame();
             }
         }
+    }
 
-        gameState.update();
+    if(profilePath != nullptr)
+    {
+        Profiler::writeReport(profilePath);
+    }
+    if(tracePath != nullptr)
+    {
+        TraceRecorder::writeJson(tracePath);
     }
 
-quit:
-    SDL_DestroyRenderer(renderer);
+    if(framebuffer == nullptr)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
+    framebuffer.reset();
     SDL_DestroyWindow(window);
     SDL_Quit();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,430 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "Clock.hpp"
+#include "Framebuffer.hpp"
+#include "GameRenderer.hpp"
+#include "GameState.hpp"
+#include "TimerService.hpp"
+#include "font.hpp"
+
+// Times the game's hot paths one at a time: the simulation tick and its parts, and the drawing steps, which render
+// into a window-less Framebuffer so no display or GPU is needed. Every sample starts from the same saved game state.
+//
+//     pacman_bench [--filter TEXT] [--repetitions N] [--warmup N] [--json FILE] [--compare FILE [--threshold PCT]]
+//
+// --json writes the results for use as a baseline later. --compare reads such a file and fails (exit status 1) if any
+// benchmark's median got slower by more than the threshold, 10% by default.
+
+struct BenchmarkOptions
+{
+    std::string filter;
+    int repetitions = 200;
+    int warmup = 20;
+    const char* jsonPath = nullptr;
+    const char* comparePath = nullptr;
+    double thresholdPercent = 10.0;
+};
+
+struct Benchmark
+{
+    std::string name;
+    std::function<void()> prepare; // untimed, before every sample
+    std::function<void()> run;     // one timed iteration
+    int maxBatch;                  // most iterations per sample, for benchmarks that move the state on
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    int batch;
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+};
+
+// a sample should be long enough that the clock's resolution doesn't matter
+static const uint64_t MIN_SAMPLE_NS = 50'000;
+
+static BenchmarkResult runBenchmark(const Benchmark& benchmark, const BenchmarkOptions& options)
+{
+    const RealTimeClock clock;
+    const auto timeSample = [&](int batch)
+    {
+        benchmark.prepare();
+        const uint64_t start = clock.now();
+        for(int iteration = 0; iteration < batch; iteration++)
+        {
+            benchmark.run();
+        }
+        return clock.now() - start;
+    };
+
+    // one iteration to size the batches, then warm up caches and branch predictors
+    const uint64_t singleNs = std::max<uint64_t>(1, timeSample(1));
+    const int batch = (int)std::clamp<uint64_t>(MIN_SAMPLE_NS / singleNs, 1, (uint64_t)benchmark.maxBatch);
+    for(int sample = 0; sample < options.warmup; sample++)
+    {
+        timeSample(batch);
+    }
+
+    std::vector<double> samples(std::max(1, options.repetitions));
+    for(double& sample : samples)
+    {
+        sample = (double)timeSample(batch) / batch;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.batch = batch;
+    result.medianNs = samples[samples.size() / 2];
+    result.p99Ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    double total = 0.0;
+    for(const double sample : samples)
+    {
+        total += sample;
+    }
+    result.meanNs = total / samples.size();
+    return result;
+}
+
+// Owns the fixed states the benchmarks run against. A friend of GameState and GameRenderer so private steps can be
+// timed on their own.
+class Benchmarks
+{
+public:
+    Benchmarks();
+    std::vector<Benchmark> makeBenchmarks();
+
+private:
+    void restoreGame();
+    void flushFrame();
+
+private:
+    static inline const int IDLE_TIMERS = 64;
+    static inline const int CIRCLES_PER_ITERATION = 100;
+
+    std::unique_ptr<Framebuffer> m_framebuffer = std::make_unique<Framebuffer>(nullptr);
+    GameRenderer m_renderer {m_framebuffer->getRenderer(), m_framebuffer.get()};
+    GameState m_gameState {std::make_unique<ManualClock>()};
+    std::vector<uint8_t> m_savedState;
+    FrameSnapshot m_snapshot;
+};
+
+Benchmarks::Benchmarks()
+{
+    // past the ready timer with pacman moving and the ghosts out chasing, so every part of a tick does work
+    m_gameState.handleInput({Direction::LEFT, true});
+    for(int tick = 0; tick < GameState::TICKS_PER_SECOND * 6; tick++)
+    {
+        m_gameState.tick();
+    }
+    m_gameState.saveState(m_savedState);
+    m_gameState.fillSnapshot(m_snapshot);
+
+    // draw once so the board texture and text cache are built before anything is timed
+    m_renderer.render(m_snapshot, m_snapshot.tickTime);
+}
+
+void Benchmarks::restoreGame()
+{
+    m_gameState.restoreState(m_savedState.data(), m_savedState.size());
+}
+
+void Benchmarks::flushFrame()
+{
+    m_renderer.m_drawBatch.flush();
+}
+
+std::vector<Benchmark> Benchmarks::makeBenchmarks()
+{
+    const auto noPrepare = []() {};
+    const auto restore = [this]() { restoreGame(); };
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({"GameState::tick", restore, [this]() { m_gameState.tick(); }, 60});
+    benchmarks.push_back(
+        {"Ghost::update",
+         restore,
+         [this]()
+         {
+             for(auto& ghost : m_gameState.m_ghosts)
+             {
+                 ghost->update();
+             }
+         },
+         60});
+    benchmarks.push_back(
+        {"TimerService::checkTimers",
+         [this]()
+         {
+             // the game's own timers plus some idle ones, none of them due, released so they outlive the setup
+             restoreGame();
+             auto& timerService = m_gameState.m_timerService;
+             for(int timer = 0; timer < IDLE_TIMERS; timer++)
+             {
+                 timerService.startTimer(timerService.addTimer(UINT32_MAX, false, []() {}).release());
+             }
+         },
+         [this]() { m_gameState.m_timerService.checkTimers(m_gameState.getSimulationTimeMs()); },
+         1000});
+    benchmarks.push_back(
+        {"GameState::computeStateHash",
+         restore,
+         [this]()
+         {
+             volatile uint64_t hash = m_gameState.computeStateHash();
+             (void)hash;
+         },
+         1000});
+
+    benchmarks.push_back(
+        {"drawFilledCircle x100",
+         noPrepare,
+         [this]()
+         {
+             for(int circle = 0; circle < CIRCLES_PER_ITERATION; circle++)
+             {
+                 drawFilledCircle(m_renderer.m_drawBatch, 40 + circle * 5, 300, 8, COLOR_WHITE);
+             }
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"GameRenderer::drawBoundary (whole board)",
+         noPrepare,
+         [this]()
+         {
+             const Bitboard& board = m_snapshot.board;
+             for(int row = 0; row < board.getRows(); row++)
+             {
+                 for(int col = 0; col < board.getCols(); col++)
+                 {
+                     if(board.isWall(row, col))
+                     {
+                         m_renderer.drawBoundary(board, row, col);
+                     }
+                 }
+             }
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"GameRenderer::drawBoardTiles",
+         noPrepare,
+         [this]()
+         {
+             m_renderer.drawBoardTiles(m_snapshot.board);
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"GameRenderer::drawFullBoard",
+         noPrepare,
+         [this]()
+         {
+             m_renderer.drawFullBoard(m_snapshot.board);
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"drawStringGlyphs",
+         noPrepare,
+         [this]()
+         {
+             drawStringGlyphs(m_renderer.m_atlas, 150, 6, "HIGH SCORE", COLOR_WHITE, 2);
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"TextCache::draw",
+         noPrepare,
+         [this]()
+         {
+             m_renderer.m_textCache.draw(150, 6, "HIGH SCORE", COLOR_WHITE, 2);
+             flushFrame();
+         },
+         1000});
+    benchmarks.push_back(
+        {"GameRenderer::render",
+         noPrepare,
+         [this]() { m_renderer.render(m_snapshot, m_snapshot.tickTime); },
+         1000});
+
+    return benchmarks;
+}
+
+static void writeJson(const char* path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to write %s", path);
+        return;
+    }
+
+    file << "{\n  \"benchmarks\": [\n";
+    for(size_t index = 0; index < results.size(); index++)
+    {
+        const BenchmarkResult& result = results[index];
+        file << "    {\"name\": \"" << result.name << "\", \"batch\": " << result.batch
+             << ", \"median_ns\": " << result.medianNs << ", \"p99_ns\": " << result.p99Ns
+             << ", \"mean_ns\": " << result.meanNs << "}" << (index + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
+
+// only understands what writeJson writes, one benchmark per line
+static bool readBaseline(const char* path, std::map<std::string, double>& medians)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to open baseline %s", path);
+        return false;
+    }
+
+    static const std::string NAME_FIELD = "\"name\": \"";
+    static const std::string MEDIAN_FIELD = "\"median_ns\": ";
+    std::string line;
+    while(std::getline(file, line))
+    {
+        const size_t name = line.find(NAME_FIELD);
+        const size_t median = line.find(MEDIAN_FIELD);
+        if(name == std::string::npos || median == std::string::npos)
+        {
+            continue;
+        }
+        const size_t nameStart = name + NAME_FIELD.size();
+        const size_t nameEnd = line.find('"', nameStart);
+        medians[line.substr(nameStart, nameEnd - nameStart)] = atof(line.c_str() + median + MEDIAN_FIELD.size());
+    }
+    return true;
+}
+
+static bool compareWithBaseline(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options)
+{
+    std::map<std::string, double> baseline;
+    if(!readBaseline(options.comparePath, baseline))
+    {
+        return false;
+    }
+
+    bool regressed = false;
+    printf("\n%-42s %14s %14s %9s\n", "compared with baseline", "baseline ns", "median ns", "change");
+    for(const BenchmarkResult& result : results)
+    {
+        const auto it = baseline.find(result.name);
+        if(it == baseline.end() || it->second <= 0.0)
+        {
+            printf("%-42s %14s %14.1f %9s\n", result.name.c_str(), "-", result.medianNs, "new");
+            continue;
+        }
+
+        const double changePercent = (result.medianNs / it->second - 1.0) * 100.0;
+        const bool slower = changePercent > options.thresholdPercent;
+        regressed = regressed || slower;
+        printf(
+            "%-42s %14.1f %14.1f %+8.1f%%%s\n",
+            result.name.c_str(),
+            it->second,
+            result.medianNs,
+            changePercent,
+            slower ? "  REGRESSION" : "");
+    }
+    return !regressed;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        if(strcmp(argv[arg], "--filter") == 0 && arg + 1 < argc)
+        {
+            options.filter = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--repetitions") == 0 && arg + 1 < argc)
+        {
+            options.repetitions = atoi(argv[++arg]);
+        }
+        else if(strcmp(argv[arg], "--warmup") == 0 && arg + 1 < argc)
+        {
+            options.warmup = atoi(argv[++arg]);
+        }
+        else if(strcmp(argv[arg], "--json") == 0 && arg + 1 < argc)
+        {
+            options.jsonPath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--compare") == 0 && arg + 1 < argc)
+        {
+            options.comparePath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc)
+        {
+            options.thresholdPercent = atof(argv[++arg]);
+        }
+        else if(strcmp(argv[arg], "--log") == 0 && arg + 1 < argc)
+        {
+            if(!Logger::configure(argv[++arg]))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            LOG_WARN("Ignoring unknown argument %s", argv[arg]);
+        }
+    }
+
+    // the framebuffer renders into memory, nothing needs a video driver
+    LOG_ASSERT(SDL_Init(0) == 0, "SDL init error: %s", SDL_GetError());
+
+    std::vector<BenchmarkResult> results;
+    {
+        Benchmarks benchmarks;
+        printf("%-42s %8s %14s %14s %14s\n", "benchmark", "batch", "median ns", "p99 ns", "mean ns");
+        for(const Benchmark& benchmark : benchmarks.makeBenchmarks())
+        {
+            if(benchmark.name.find(options.filter) == std::string::npos)
+            {
+                continue;
+            }
+            const BenchmarkResult result = runBenchmark(benchmark, options);
+            // so the table isn't broken up by what the benchmark logged
+            Logger::flush();
+            printf(
+                "%-42s %8d %14.1f %14.1f %14.1f\n",
+                result.name.c_str(),
+                result.batch,
+                result.medianNs,
+                result.p99Ns,
+                result.meanNs);
+            fflush(stdout);
+            results.push_back(result);
+        }
+    }
+
+    if(options.jsonPath != nullptr)
+    {
+        writeJson(options.jsonPath, results);
+    }
+
+    bool passed = true;
+    if(options.comparePath != nullptr)
+    {
+        passed = compareWithBaseline(results, options);
+    }
+
+    SDL_Quit();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
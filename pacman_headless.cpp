@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <SDL.h>
+#include "Clock.hpp"
+#include "FrameRenderer.hpp"
+#include "GameState.hpp"
+#include "InputScript.hpp"
+#include "Profiler.hpp"
+#include "ReplayLog.hpp"
+
+// Runs the game with no window and no video driver, as fast as the simulation allows, then prints the final score,
+// level and tick count. Used for gameplay regression runs and AI workloads.
+//
+// A script (--script FILE, see InputScript.hpp) drives the input.
+//
+// --record FILE writes the run to a replay log (see ReplayLog.hpp). --replay FILE plays a log back instead, checking
+// the state after every tick against the recording and reporting the first tick where they differ. With --seek TICK
+// the replay starts from that tick, restoring the nearest keyframe rather than simulating from the start.
+
+static const uint64_t DEFAULT_MAX_TICKS = (uint64_t)GameState::TICKS_PER_SECOND * 60 * 10;
+
+// returns the number of the first tick whose state doesn't match the recording, if any
+static std::optional<uint64_t> replay(ReplayReader& reader, GameState& gameState, ManualClock& gameClock)
+{
+    if(reader.getNextTick() == 0 && gameState.computeStateHash() != reader.getInitialStateHash())
+    {
+        LOG_ERROR("Starting state doesn't match the recording");
+        return 0;
+    }
+
+    std::vector<InputEvent> inputs;
+    uint64_t recordedHash = 0;
+    for(uint64_t tick = reader.getNextTick(); reader.readTick(inputs, recordedHash); tick++)
+    {
+        for(const InputEvent& input : inputs)
+        {
+            gameState.handleInput(input);
+        }
+        gameState.tick();
+        gameClock.advance(Clock::NANOSECONDS_PER_SECOND / GameState::TICKS_PER_SECOND);
+
+        const uint64_t stateHash = gameState.computeStateHash();
+        if(stateHash != recordedHash)
+        {
+            LOG_ERROR(
+                "Tick %llu: state hash %016llx, recorded %016llx",
+                (unsigned long long)tick,
+                (unsigned long long)stateHash,
+                (unsigned long long)recordedHash);
+            return tick;
+        }
+    }
+    return std::nullopt;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t maxTicks = DEFAULT_MAX_TICKS;
+    std::vector<ScriptedInput> script;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    uint64_t seekTick = 0;
+    const char* profilePath = nullptr;
+    const char* tracePath = nullptr;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        if(strcmp(argv[arg], "--ticks") == 0 && arg + 1 < argc)
+        {
+            maxTicks = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--script") == 0 && arg + 1 < argc)
+        {
+            if(!loadInputScript(argv[++arg], script))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[arg], "--record") == 0 && arg + 1 < argc)
+        {
+            recordPath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--replay") == 0 && arg + 1 < argc)
+        {
+            replayPath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--seek") == 0 && arg + 1 < argc)
+        {
+            seekTick = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--profile") == 0 && arg + 1 < argc)
+        {
+            profilePath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc)
+        {
+            tracePath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--log") == 0 && arg + 1 < argc)
+        {
+            if(!Logger::configure(argv[++arg]))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            LOG_WARN("Ignoring unknown argument %s", argv[arg]);
+        }
+    }
+
+    if(profilePath != nullptr)
+    {
+        Profiler::enable();
+    }
+    if(tracePath != nullptr)
+    {
+        TraceRecorder::start();
+        TraceRecorder::setThreadName("simulation");
+    }
+    const auto writeReports = [&]()
+    {
+        if(profilePath != nullptr)
+        {
+            Profiler::writeReport(profilePath);
+        }
+        if(tracePath != nullptr)
+        {
+            TraceRecorder::writeJson(tracePath);
+        }
+    };
+
+    // game time is stepped a tick at a time, as fast as the ticks run
+    auto clock = std::make_unique<ManualClock>();
+    ManualClock& gameClock = *clock;
+    GameState gameState(std::move(clock));
+    NullRenderer renderer;
+    FrameSnapshot snapshot;
+
+    const RealTimeClock realTime;
+    if(replayPath != nullptr)
+    {
+        ReplayReader reader;
+        if(!reader.open(replayPath))
+        {
+            return EXIT_FAILURE;
+        }
+        if(seekTick > 0)
+        {
+            if(!reader.seek(seekTick, gameState))
+            {
+                return EXIT_FAILURE;
+            }
+            LOG_INFO(
+                "Seeked to tick %llu in %.3f s",
+                (unsigned long long)seekTick,
+                (double)realTime.now() / Clock::NANOSECONDS_PER_SECOND);
+        }
+
+        const std::optional<uint64_t> divergedTick = replay(reader, gameState, gameClock);
+        writeReports();
+        gameState.fillSnapshot(snapshot);
+        LOG_INFO(
+            "Replayed %llu ticks in %.3f s",
+            (unsigned long long)snapshot.tick,
+            (double)realTime.now() / Clock::NANOSECONDS_PER_SECOND);
+        // results go after the log lines that led up to them
+        Logger::flush();
+        if(divergedTick.has_value())
+        {
+            printf("diverged at tick %llu\n", (unsigned long long)*divergedTick);
+            return EXIT_FAILURE;
+        }
+        printf(
+            "replay matched, score %d level %d ticks %llu\n",
+            snapshot.score,
+            snapshot.level,
+            (unsigned long long)snapshot.tick);
+        return EXIT_SUCCESS;
+    }
+
+    ReplayWriter recorder;
+    if(recordPath != nullptr && !recorder.open(recordPath, gameState))
+    {
+        return EXIT_FAILURE;
+    }
+
+    size_t nextInput = 0;
+    std::vector<InputEvent> tickInputs;
+    for(uint64_t tick = 0; tick < maxTicks && !gameState.gameOver(); tick++)
+    {
+        tickInputs.clear();
+        while(nextInput < script.size() && script[nextInput].tick <= tick)
+        {
+            tickInputs.push_back(script[nextInput++].input);
+        }
+        for(const InputEvent& input : tickInputs)
+        {
+            gameState.handleInput(input);
+        }
+
+        gameState.tick();
+        if(recordPath != nullptr)
+        {
+            recorder.writeTick(tickInputs, gameState);
+        }
+        gameClock.advance(Clock::NANOSECONDS_PER_SECOND / GameState::TICKS_PER_SECOND);
+
+        // same path as a windowed frame, minus the drawing
+        gameState.fillSnapshot(snapshot);
+        renderer.render(snapshot, gameClock.now());
+    }
+    const double seconds = (double)realTime.now() / Clock::NANOSECONDS_PER_SECOND;
+
+    LOG_INFO("Simulated %.1f s of play in %.3f s", (double)snapshot.tick / GameState::TICKS_PER_SECOND, seconds);
+    const TimerService::Stats& timerStats = gameState.getTimerService().getStats();
+    LOG_INFO(
+        "Timers: %zu live, %zu at most, %llu added, %llu expired, %llu stopped",
+        timerStats.live,
+        timerStats.peak,
+        (unsigned long long)timerStats.added,
+        (unsigned long long)timerStats.expired,
+        (unsigned long long)timerStats.stopped);
+    recorder.close();
+    Logger::flush();
+    printf("score %d level %d ticks %llu\n", snapshot.score, snapshot.level, (unsigned long long)snapshot.tick);
+    writeReports();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "Clock.hpp"
+#include "FrameSnapshot.hpp"
+#include "GameState.hpp"
+#include "InputScript.hpp"
+#include "WorkStealingPool.hpp"
+
+// Plays many complete games headless, spread over every core, and reports how fast they ran along with the spread of
+// scores and levels reached. Used to see how gameplay changes and bots do over a large number of games.
+//
+//     pacman_runner [--games N] [--threads N] [--ticks N] [--script FILE]... [--bot] [--seed N] [--csv FILE]
+//
+// Each game is driven by an input script (see InputScript.hpp) or by a bot that holds random directions for random
+// stretches. With several sources the games take turns, game i using source i modulo the number of sources; with none
+// every game gets the bot. A game ends at game over or after --ticks ticks. Bot games are seeded from --seed and the
+// game's number, so a run plays out the same whatever the number of threads. --csv writes one line per game.
+
+struct GameResult
+{
+    int score;
+    int level;
+    uint64_t ticks;
+    bool gameOver;
+};
+
+// what drives one game, asked for the input before every tick
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+    virtual void getInputs(uint64_t tick, std::vector<InputEvent>& inputs) = 0;
+};
+
+class ScriptInput : public InputSource
+{
+public:
+    ScriptInput(const std::vector<ScriptedInput>& script) : m_script(script) {}
+
+    void getInputs(uint64_t tick, std::vector<InputEvent>& inputs) override
+    {
+        while(m_nextInput < m_script.size() && m_script[m_nextInput].tick <= tick)
+        {
+            inputs.push_back(m_script[m_nextInput++].input);
+        }
+    }
+
+private:
+    const std::vector<ScriptedInput>& m_script;
+    size_t m_nextInput = 0;
+};
+
+class RandomBot : public InputSource
+{
+public:
+    RandomBot(uint64_t seed) : m_random(seed) {}
+
+    void getInputs(uint64_t tick, std::vector<InputEvent>& inputs) override
+    {
+        if(tick < m_nextChange)
+        {
+            return;
+        }
+        if(m_holding)
+        {
+            inputs.push_back({m_held, false});
+        }
+        m_held = (Direction)(next() % (uint64_t)Direction::MAX);
+        m_holding = true;
+        inputs.push_back({m_held, true});
+        m_nextChange = tick + MIN_HOLD_TICKS + next() % (MAX_HOLD_TICKS - MIN_HOLD_TICKS);
+    }
+
+private:
+    static inline const uint64_t MIN_HOLD_TICKS = GameState::TICKS_PER_SECOND / 4;
+    static inline const uint64_t MAX_HOLD_TICKS = GameState::TICKS_PER_SECOND * 2;
+
+    // splitmix64, so neighbouring seeds still give unrelated games
+    uint64_t next()
+    {
+        uint64_t value = (m_random += 0x9e3779b97f4a7c15ull);
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t m_random;
+    uint64_t m_nextChange = 0;
+    Direction m_held = Direction::LEFT;
+    bool m_holding = false;
+};
+
+// Everything a worker reuses from one game to the next. The game itself is put back to the starting state rather than
+// built again, so after its first game a worker runs without allocating, and no two workers share anything they write.
+struct alignas(64) WorkerArena
+{
+    std::unique_ptr<GameState> gameState;
+    ManualClock* gameClock = nullptr;
+    std::vector<InputEvent> inputs;
+    FrameSnapshot snapshot;
+};
+
+static const uint64_t DEFAULT_MAX_TICKS = (uint64_t)GameState::TICKS_PER_SECOND * 60 * 10;
+
+static GameResult playGame(
+    WorkerArena& arena,
+    const std::vector<uint8_t>& startingState,
+    InputSource& inputSource,
+    uint64_t maxTicks)
+{
+    if(arena.gameState == nullptr)
+    {
+        auto clock = std::make_unique<ManualClock>();
+        arena.gameClock = clock.get();
+        arena.gameState = std::make_unique<GameState>(std::move(clock));
+    }
+    GameState& gameState = *arena.gameState;
+    gameState.restoreState(startingState.data(), startingState.size());
+
+    uint64_t tick = 0;
+    for(; tick < maxTicks && !gameState.gameOver(); tick++)
+    {
+        arena.inputs.clear();
+        inputSource.getInputs(tick, arena.inputs);
+        for(const InputEvent& input : arena.inputs)
+        {
+            gameState.handleInput(input);
+        }
+        gameState.tick();
+        arena.gameClock->advance(Clock::NANOSECONDS_PER_SECOND / GameState::TICKS_PER_SECOND);
+    }
+
+    gameState.fillSnapshot(arena.snapshot);
+    return {arena.snapshot.score, arena.snapshot.level, tick, gameState.gameOver()};
+}
+
+static bool writeCsv(const char* path, const std::vector<GameResult>& results)
+{
+    std::ofstream file(path);
+    if(!file)
+    {
+        LOG_ERROR("Unable to write %s", path);
+        return false;
+    }
+    file << "game,score,level,ticks,game_over\n";
+    for(size_t game = 0; game < results.size(); game++)
+    {
+        const GameResult& result = results[game];
+        file << game << ',' << result.score << ',' << result.level << ',' << result.ticks << ','
+             << (result.gameOver ? 1 : 0) << '\n';
+    }
+    return true;
+}
+
+static void printReport(const std::vector<GameResult>& results, size_t threads, double seconds)
+{
+    uint64_t totalTicks = 0;
+    double totalScore = 0;
+    size_t gamesOver = 0;
+    std::vector<int> scores;
+    std::vector<size_t> gamesPerLevel;
+    scores.reserve(results.size());
+    for(const GameResult& result : results)
+    {
+        totalTicks += result.ticks;
+        totalScore += result.score;
+        gamesOver += result.gameOver ? 1 : 0;
+        scores.push_back(result.score);
+        if((size_t)result.level >= gamesPerLevel.size())
+        {
+            gamesPerLevel.resize(result.level + 1);
+        }
+        gamesPerLevel[result.level]++;
+    }
+    std::sort(scores.begin(), scores.end());
+    const auto percentile = [&](int percent) { return scores[(scores.size() - 1) * percent / 100]; };
+
+    printf(
+        "%zu games on %zu threads in %.3f s, %.1f games/s, %.0fx real time\n",
+        results.size(),
+        threads,
+        seconds,
+        results.size() / seconds,
+        (double)totalTicks / GameState::TICKS_PER_SECOND / seconds);
+    printf(
+        "score mean %.1f min %d p10 %d p50 %d p90 %d max %d\n",
+        totalScore / results.size(),
+        scores.front(),
+        percentile(10),
+        percentile(50),
+        percentile(90),
+        scores.back());
+    for(size_t level = 0; level < gamesPerLevel.size(); level++)
+    {
+        if(gamesPerLevel[level] > 0)
+        {
+            printf(
+                "level %zu reached by %zu games (%.1f%%)\n",
+                level,
+                gamesPerLevel[level],
+                100.0 * gamesPerLevel[level] / results.size());
+        }
+    }
+    printf("%zu games over, %zu stopped at the tick limit\n", gamesOver, results.size() - gamesOver);
+}
+
+int main(int argc, char** argv)
+{
+    // hundreds of games logging every point scored would only flood the log
+    Logger::configure("warn");
+
+    size_t games = 100;
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    uint64_t maxTicks = DEFAULT_MAX_TICKS;
+    std::vector<std::vector<ScriptedInput>> scripts;
+    bool useBot = false;
+    uint64_t seed = 1;
+    const char* csvPath = nullptr;
+    for(int arg = 1; arg < argc; arg++)
+    {
+        if(strcmp(argv[arg], "--games") == 0 && arg + 1 < argc)
+        {
+            games = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+        {
+            threads = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--ticks") == 0 && arg + 1 < argc)
+        {
+            maxTicks = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--script") == 0 && arg + 1 < argc)
+        {
+            scripts.emplace_back();
+            if(!loadInputScript(argv[++arg], scripts.back()))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[arg], "--bot") == 0)
+        {
+            useBot = true;
+        }
+        else if(strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc)
+        {
+            seed = strtoull(argv[++arg], nullptr, 10);
+        }
+        else if(strcmp(argv[arg], "--csv") == 0 && arg + 1 < argc)
+        {
+            csvPath = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "--log") == 0 && arg + 1 < argc)
+        {
+            if(!Logger::configure(argv[++arg]))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            LOG_WARN("Ignoring unknown argument %s", argv[arg]);
+        }
+    }
+    if(games == 0)
+    {
+        LOG_ERROR("Nothing to run, --games must be at least 1");
+        return EXIT_FAILURE;
+    }
+    useBot = useBot || scripts.empty();
+    const size_t sourceCount = scripts.size() + (useBot ? 1 : 0);
+
+    // every game starts from this, however many the arena it runs in has played before
+    std::vector<uint8_t> startingState;
+    GameState(std::make_unique<ManualClock>()).saveState(startingState);
+
+    WorkStealingPool pool(threads);
+    std::vector<WorkerArena> arenas(pool.getThreadCount());
+    std::vector<GameResult> results(games);
+
+    const RealTimeClock realTime;
+    pool.run(
+        games,
+        [&](size_t game, size_t worker)
+        {
+            const size_t source = game % sourceCount;
+            if(source < scripts.size())
+            {
+                ScriptInput input(scripts[source]);
+                results[game] = playGame(arenas[worker], startingState, input, maxTicks);
+            }
+            else
+            {
+                RandomBot bot(seed + game);
+                results[game] = playGame(arenas[worker], startingState, bot, maxTicks);
+            }
+        });
+    const double seconds = (double)realTime.now() / Clock::NANOSECONDS_PER_SECOND;
+
+    // results go after the log lines that led up to them
+    Logger::flush();
+    printReport(results, pool.getThreadCount(), seconds);
+    if(csvPath != nullptr && !writeCsv(csvPath, results))
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
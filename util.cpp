@@ -1,20 +1,25 @@
 #include <SDL.h>
+#include "DrawBatch.hpp"
+#include "Spans.hpp"
 #include "util.hpp"
 
-void drawFilledCircle(
-    SDL_Renderer* renderer, const int xCenter, const int yCenter, const int radius, const SDL_Color& color)
+void drawFilledCircle(DrawBatch& batch, const int xCenter, const int yCenter, const int radius, const SDL_Color& color)
 {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    for(int x = 0; x < radius * 2; x++)
+    for(const Span& span : getCircleSpans(radius))
     {
-        for(int y = 0; y < radius * 2; y++)
+        batch.fillRect({xCenter + span.dxStart, yCenter + span.dy, span.length, 1}, color);
+    }
+}
+
+BoardLayout getWallLayout(const BoardLayout& layout)
+{
+    BoardLayout walls = layout;
+    for(std::string& row : walls)
+    {
+        for(char& tile : row)
         {
-            int dx = radius - x;
-            int dy = radius - y;
-            if(dx * dx + dy * dy <= radius * radius)
-            {
-                SDL_RenderDrawPoint(renderer, xCenter + dx, yCenter + dy);
-            }
+            tile = tile == BOUNDARY || tile == WRAP ? tile : ' ';
         }
     }
+    return walls;
 }
@@ -2,53 +2,16 @@
 
 #include <stdio.h>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "Logger.hpp"
+
 // forward declaration
-struct SDL_Renderer;
-
-#define LOG_LEVEL_TRACE (6)
-#define LOG_LEVEL_DEBUG (5)
-#define LOG_LEVEL_INFO (4)
-#define LOG_LEVEL_WARN (3)
-#define LOG_LEVEL_ERROR (2)
-#define LOG_LEVEL_ASSERT (1)
-
-#define activeLevel LOG_LEVEL_INFO
-
-// GNU C++ doesn't handle empty __VA_ARGS__ the same as MSVC
-#ifdef __GNUG__
-#define LOG_AT_LEVEL(level, format, ...) \
-    if(activeLevel >= level)             \
-    printf("[%s] %s:%d: " format "\n", #level, __FILE__, __LINE__, ##__VA_ARGS__)
-#define LOG_TRACE(format, ...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, format, ##__VA_ARGS__)
-#define LOG_DEBUG(format, ...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
-#define LOG_INFO(format, ...) LOG_AT_LEVEL(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
-#define LOG_WARN(format, ...) LOG_AT_LEVEL(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
-#define LOG_ERROR(format, ...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
-#define LOG_ASSERT(condition, format, ...)                                           \
-    if(!(condition))                                                                 \
-    {                                                                                \
-        LOG_AT_LEVEL(LOG_LEVEL_ASSERT, #condition " fails, " format, ##__VA_ARGS__); \
-        exit(EXIT_FAILURE);                                                          \
-    }
-#else
-#define LOG_AT_LEVEL(level, format, ...) \
-    if(activeLevel >= level)             \
-    printf("[%s] %s:%d: " format "\n", #level, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_TRACE(format, ...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, format, __VA_ARGS__)
-#define LOG_DEBUG(format, ...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, format, __VA_ARGS__)
-#define LOG_INFO(format, ...) LOG_AT_LEVEL(LOG_LEVEL_INFO, format, __VA_ARGS__)
-#define LOG_WARN(format, ...) LOG_AT_LEVEL(LOG_LEVEL_WARN, format, __VA_ARGS__)
-#define LOG_ERROR(format, ...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, format, __VA_ARGS__)
-#define LOG_ASSERT(condition, format, ...)                                         \
-    if(!(condition))                                                               \
-    {                                                                              \
-        LOG_AT_LEVEL(LOG_LEVEL_ASSERT, #condition " fails, " format, __VA_ARGS__); \
-        exit(EXIT_FAILURE);                                                        \
-    }
-#endif
+class DrawBatch;
 
 const int X_INCREMENT[] = {0, 0, -1, 1, 0};
 const int Y_INCREMENT[] = {-1, 1, 0, 0, 0};
@@ -102,6 +65,7 @@ const int SCREEN_HEIGHT = 960;
 const int TILE_WIDTH = SCREEN_WIDTH / (int)BASE_LAYOUT[0].length();
 const int TILE_HEIGHT = SCREEN_HEIGHT / (int)BASE_LAYOUT.size();
 
+const SDL_Color COLOR_BLACK = {0x00, 0x00, 0x00, 0xff};
 const SDL_Color COLOR_RED = {0xff, 0x00, 0x00, 0xff};
 const SDL_Color COLOR_GREEN = {0x00, 0xff, 0x00, 0xff};
 const SDL_Color COLOR_BLUE = {0x00, 0x00, 0xff, 0xff};
@@ -125,8 +89,34 @@ enum class Direction
 
 const char* const DIRECTION_AS_STRING[] = {"UP", "DOWN", "LEFT", "RIGHT", "MAX"};
 
+struct GridPosition
+{
+    int row;
+    int col;
+};
+
 #define X_CENTER(col) ((col)*TILE_WIDTH + TILE_WIDTH / 2)
 #define Y_CENTER(row) ((row)*TILE_HEIGHT + TILE_HEIGHT / 2)
 
-void drawFilledCircle(
-    SDL_Renderer* renderer, const int xCenter, const int yCenter, const int radius, const SDL_Color& color);
+// the layout with everything but walls and WRAP tiles turned into open floor
+BoardLayout getWallLayout(const BoardLayout& layout);
+
+// One T built from each wall layout the first time it's asked for, then shared by every game on the same walls. A
+// board with its dots eaten gets the same one. Safe to call from any thread.
+template<typename T>
+std::shared_ptr<const T> getSharedForLayout(const BoardLayout& layout)
+{
+    static std::mutex cacheMutex;
+    static std::map<BoardLayout, std::shared_ptr<const T>> cache;
+
+    BoardLayout key = getWallLayout(layout);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if(it == cache.end())
+    {
+        it = cache.emplace(std::move(key), std::make_shared<const T>(layout)).first;
+    }
+    return it->second;
+}
+
+void drawFilledCircle(DrawBatch& batch, const int xCenter, const int yCenter, const int radius, const SDL_Color& color);